@@ -0,0 +1,39 @@
+#!/bin/bash
+# Runs obwody end to end on generated netlists, printing throughput and peak memory for every size.
+# Usage: ./bench.sh [-j jobs] [lines...]     (default sizes: 1000000 10000000 100000000)
+# Generator options, e.g. GEN_OPTIONS="--distribution zipf --error-rate 0.1", are passed to gen_netlist.
+# Netlists are written to $BENCH_DIR (default /tmp), a 100M line one takes about 3 GB.
+
+set -e
+cd "$(dirname "$0")"
+
+JOBS=1
+if [ "$1" == "-j" ]; then
+    JOBS=$2
+    shift 2
+fi
+SIZES=${@:-1000000 10000000 100000000}
+BENCH_DIR=${BENCH_DIR:-/tmp}
+
+g++ -Wall -Wextra -O2 -std=c++17 gen_netlist.cc -o gen_netlist
+g++ -Wall -Wextra -O2 -std=c++17 -pthread -DOBWODY_STATS ../obwody.cc ../netlist.cc -o obwody_stats
+
+printf "%12s %10s %10s %14s %10s %12s\n" lines MB seconds "lines/s" "MB/s" "peak KiB"
+for lines in $SIZES; do
+    netlist="$BENCH_DIR/obwody_bench_$lines.in"
+    ./gen_netlist --lines "$lines" $GEN_OPTIONS > "$netlist"
+    bytes=$(stat -c %s "$netlist")
+
+    start=$(date +%s.%N)
+    stats=$(./obwody_stats -j "$JOBS" --stats "$netlist" 3>&1 >/dev/null 2>/dev/null)
+    end=$(date +%s.%N)
+    rm -f "$netlist"
+
+    peak=$(echo "$stats" | sed -n 's/^peak memory: \([0-9]*\) KiB$/\1/p')
+    awk -v lines="$lines" -v bytes="$bytes" -v seconds="$(awk -v a="$start" -v b="$end" 'BEGIN {print b - a}')" -v peak="$peak" 'BEGIN {
+        printf "%12d %10.1f %10.3f %14.0f %10.1f %12d\n",
+            lines, bytes / 1e6, seconds, lines / seconds, bytes / 1e6 / seconds, peak
+    }'
+done
+
+rm -f gen_netlist obwody_stats
@@ -0,0 +1,220 @@
+/**
+ * Deterministic generator of synthetic netlists for benchmarking obwody.
+ *
+ * Usage: gen_netlist [options] > netlist
+ *   --lines N            number of lines (default 1000000)
+ *   --seed N             seed, the same seed always gives the same netlist (default 1)
+ *   --error-rate P       fraction of lines with syntax errors (default 0.01)
+ *   --duplicate-rate P   fraction of lines repeating an earlier designator (default 0.01)
+ *   --descriptions N     number of distinct descriptions (default 500)
+ *   --nodes N            number of distinct nodes (default lines / 2)
+ *   --distribution D     of nodes: uniform, zipf (few heavily used nets) or local
+ *                        (elements connect nodes close to each other, like real circuits)
+ */
+
+#include <array>
+#include <cmath>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    using namespace std;
+
+    inline namespace Random {
+        // SplitMix64, chosen over <random> distributions, which differ between standard libraries
+        class Generator {
+        public:
+            explicit Generator(uint64_t seed) : state(seed) {}
+
+            uint64_t next() {
+                uint64_t z {state += 0x9E3779B97F4A7C15ull};
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                return z ^ (z >> 31);
+            }
+
+            // Uniform in [0, bound)
+            uint64_t below(uint64_t bound) {
+                return static_cast<uint64_t>((static_cast<unsigned __int128>(next()) * bound) >> 64);
+            }
+
+            // Uniform in [0, 1)
+            double real() {
+                return static_cast<double>(next() >> 11) * 0x1.0p-53;
+            }
+
+        private:
+            uint64_t state;
+        };
+    }
+
+    inline namespace CommandLine {
+        enum class Distribution {
+            UNIFORM,
+            ZIPF,
+            LOCAL,
+        };
+
+        struct Settings {
+            uint64_t lines {1000000};
+            uint64_t seed {1};
+            double errorRate {0.01};
+            double duplicateRate {0.01};
+            uint64_t descriptions {500};
+            uint64_t nodes {0};
+            Distribution distribution {Distribution::UNIFORM};
+        };
+
+        template<typename T>
+        bool parseValue(string_view value, T &result) {
+            auto[end, status] = from_chars(value.data(), value.data() + value.size(), result);
+            return status == errc {} && end == value.data() + value.size();
+        }
+
+        bool parseValue(string_view value, double &result) {
+            try {
+                size_t end;
+                result = stod(string {value}, &end);
+                return end == value.size() && result >= 0 && result <= 1;
+            } catch (exception &) {
+                return false;
+            }
+        }
+
+        bool parseValue(string_view value, Distribution &result) {
+            if (value == "uniform") result = Distribution::UNIFORM;
+            else if (value == "zipf") result = Distribution::ZIPF;
+            else if (value == "local") result = Distribution::LOCAL;
+            else return false;
+            return true;
+        }
+
+        bool parseSettings(int argc, char *argv[], Settings &settings) {
+            for (int i {1}; i + 1 < argc; i += 2) {
+                string_view option {argv[i]}, value {argv[i + 1]};
+                bool correct {
+                        option == "--lines" ? parseValue(value, settings.lines) :
+                        option == "--seed" ? parseValue(value, settings.seed) :
+                        option == "--error-rate" ? parseValue(value, settings.errorRate) :
+                        option == "--duplicate-rate" ? parseValue(value, settings.duplicateRate) :
+                        option == "--descriptions" ? parseValue(value, settings.descriptions) :
+                        option == "--nodes" ? parseValue(value, settings.nodes) :
+                        option == "--distribution" && parseValue(value, settings.distribution)
+                };
+                if (!correct) return false;
+            }
+            if (settings.nodes == 0) settings.nodes = max<uint64_t>(settings.lines / 2, 3);
+            return argc % 2 == 1 && settings.descriptions > 0 && settings.nodes <= 1000000000;
+        }
+    }
+
+    inline namespace Netlist {
+        constexpr array<char, 5> letters {'T', 'D', 'R', 'C', 'E'};
+        constexpr uint64_t maxNumber {1000000000};
+
+        // Distinct descriptions built from their index, all matching the description grammar
+        string description(uint64_t index) {
+            static constexpr array<string_view, 6> suffixes {"k/0,125W", "uF/6,3V", "V", "-A", "n/50V", "Ohm"};
+            return to_string(index / suffixes.size()) + string {suffixes[index % suffixes.size()]};
+        }
+
+        class NetlistGenerator {
+        public:
+            explicit NetlistGenerator(const Settings &settings) : settings(settings), random(settings.seed) {
+                for (uint64_t i {0}; i < settings.descriptions; ++i) {
+                    descriptions.push_back(description(i));
+                }
+            }
+
+            void generate(FILE *output) {
+                string line;
+                for (uint64_t lineIndex {0}; lineIndex < settings.lines; ++lineIndex) {
+                    line.clear();
+                    writeLine(line, lineIndex);
+                    line += '\n';
+                    fwrite(line.data(), 1, line.size(), output);
+                }
+            }
+
+        private:
+            const Settings &settings;
+            Generator random;
+            vector<string> descriptions;
+            array<uint64_t, letters.size()> used {};
+
+            uint64_t node(uint64_t lineIndex) {
+                switch (settings.distribution) {
+                    case Distribution::UNIFORM:
+                        return random.below(settings.nodes);
+                    case Distribution::ZIPF:
+                        // Inverse of a power law, low numbered nodes are by far the most popular
+                        return static_cast<uint64_t>(pow(settings.nodes + 1.0, random.real())) - 1;
+                    case Distribution::LOCAL:
+                    default:
+                        uint64_t base {lineIndex * settings.nodes / max<uint64_t>(settings.lines, 1)};
+                        return (base + random.below(8)) % settings.nodes;
+                }
+            }
+
+            void writeLine(string &line, uint64_t lineIndex) {
+                size_t type {random.below(letters.size())};
+                bool duplicate {used[type] > 0 && random.real() < settings.duplicateRate};
+                uint64_t number {duplicate ? random.below(used[type]) : used[type]++ % maxNumber};
+
+                line += letters[type];
+                line += to_string(number);
+                line += ' ';
+                line += descriptions[random.below(descriptions.size())];
+
+                size_t nodesCount {letters[type] == 'T' ? 3u : 2u};
+                array<uint64_t, 3> nodes {};
+                do {
+                    for (size_t i {0}; i < nodesCount; ++i) {
+                        nodes[i] = node(lineIndex);
+                    }
+                } while (settings.nodes > 1 && nodes[0] == nodes[1]);
+                for (size_t i {0}; i < nodesCount; ++i) {
+                    line += ' ';
+                    line += to_string(nodes[i]);
+                }
+
+                if (random.real() < settings.errorRate) {
+                    corrupt(line);
+                }
+            }
+
+            // Break the line in one of the ways people do it
+            void corrupt(string &line) {
+                switch (random.below(4)) {
+                    case 0:
+                        line.erase(line.rfind(' '));
+                        break;
+                    case 1:
+                        line.insert(1, "0");
+                        break;
+                    case 2:
+                        line[random.below(line.size())] = '#';
+                        break;
+                    default:
+                        line += " 7";
+                        break;
+                }
+            }
+        };
+    }
+}
+
+int main(int argc, char *argv[]) {
+    Settings settings;
+    if (!parseSettings(argc, argv, settings)) {
+        fprintf(stderr, "Usage: %s [--lines N] [--seed N] [--error-rate P] [--duplicate-rate P] "
+                        "[--descriptions N] [--nodes N] [--distribution uniform|zipf|local]\n", argv[0]);
+        return 1;
+    }
+
+    NetlistGenerator {settings}.generate(stdout);
+}
@@ -0,0 +1,138 @@
+/**
+ * Microbenchmark of splitting netlists into lines and tokens: getline with byte by byte tokenizing,
+ * as the stream input used to do, against the vectorized pre-pass of scan.h with each implementation
+ * the processor supports. Implementations are checked to agree with each other.
+ *
+ * Usage: scan_bench netlist [repetitions]
+ */
+
+#include "../scan.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+    using namespace std;
+    using namespace obwody;
+
+    constexpr size_t blockSize {1 << 16};
+
+    constexpr bool isSpace(char c) {
+        return c == ' ' || ('\t' <= c && c <= '\r');
+    }
+
+    // Lines and tokens seen, so that no pass can be optimized away and passes can be compared
+    using Counts = tuple<size_t, size_t>;
+
+    Counts getlinePass(const string &input) {
+        istringstream stream {input};
+        string line;
+        size_t lines {0}, tokens {0};
+        while (getline(stream, line)) {
+            ++lines;
+            for (size_t pos {0}; pos < line.size();) {
+                while (pos < line.size() && isSpace(line[pos])) ++pos;
+                if (pos == line.size()) break;
+                ++tokens;
+                while (pos < line.size() && !isSpace(line[pos])) ++pos;
+            }
+        }
+        return {lines, tokens};
+    }
+
+    // Input split into blocks ending with newlines, as the parser does it
+    Counts indexPass(string_view input, scan::IndexBlock indexBlock, scan::BlockIndex &index) {
+        size_t lines {0}, tokens {0};
+        for (size_t begin {0}; begin < input.size();) {
+            size_t end {input.size()};
+            if (end - begin > blockSize) {
+                end = input.rfind('\n', begin + blockSize - 1) + 1;
+                if (end <= begin) end = min(begin + blockSize, input.size());
+            }
+
+            indexBlock(input.substr(begin, end - begin), index);
+            lines += index.lineEndCount;
+            tokens += (index.boundaryCount + 1) / 2;
+            begin = end;
+        }
+        if (!input.empty() && input.back() != '\n') ++lines;
+        return {lines, tokens};
+    }
+
+    // Same indexes from every implementation, block by block
+    bool agree(string_view input, const vector<tuple<string, scan::IndexBlock>> &implementations) {
+        scan::BlockIndex expected, index;
+        for (size_t begin {0}; begin < input.size(); begin += blockSize) {
+            string_view block {input.substr(begin, blockSize)};
+            scan::indexBlockScalar(block, expected);
+            for (auto &[name, indexBlock] : implementations) {
+                indexBlock(block, index);
+                if (index.lineEndCount != expected.lineEndCount || index.boundaryCount != expected.boundaryCount ||
+                    !equal(expected.lineEnds.begin(), expected.lineEnds.begin() + expected.lineEndCount,
+                           index.lineEnds.begin()) ||
+                    !equal(expected.boundaries.begin(), expected.boundaries.begin() + expected.boundaryCount,
+                           index.boundaries.begin())) {
+                    fprintf(stderr, "%s disagrees with scalar at block %zu\n", name.c_str(), begin / blockSize);
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Best of @repetitions runs of @pass, in GB/s
+    double measure(const function<Counts()> &pass, size_t bytes, int repetitions, Counts &counts) {
+        double best {0};
+        for (int i {0}; i < repetitions; ++i) {
+            auto start = chrono::steady_clock::now();
+            counts = pass();
+            chrono::duration<double> elapsed {chrono::steady_clock::now() - start};
+            best = max(best, bytes / elapsed.count() / 1e9);
+        }
+        return best;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s netlist [repetitions]\n", argv[0]);
+        return 1;
+    }
+    int repetitions {argc == 3 ? stoi(argv[2]) : 5};
+
+    ifstream file {argv[1], ios::binary};
+    string input {istreambuf_iterator<char> {file}, istreambuf_iterator<char> {}};
+    if (!file && !file.eof()) {
+        fprintf(stderr, "Cannot read %s\n", argv[1]);
+        return 1;
+    }
+
+    vector<tuple<string, scan::IndexBlock>> implementations {{"scalar", scan::indexBlockScalar}};
+#ifdef OBWODY_SCAN_X86
+    if (__builtin_cpu_supports("sse2")) implementations.emplace_back("sse2", scan::indexBlockSse2);
+    if (__builtin_cpu_supports("avx2")) implementations.emplace_back("avx2", scan::indexBlockAvx2);
+#endif
+    if (!agree(input, implementations)) return 1;
+
+    printf("%.1f MB, best of %d, runtime choice: %s\n", input.size() / 1e6, repetitions,
+           scan::bestImplementation().second);
+    printf("%-24s %10s %12s %12s\n", "pass", "GB/s", "lines", "tokens");
+
+    Counts counts;
+    double speed {measure([&]() { return getlinePass(input); }, input.size(), repetitions, counts)};
+    printf("%-24s %10.2f %12zu %12zu\n", "getline + bytes", speed, get<0>(counts), get<1>(counts));
+
+    scan::BlockIndex index;
+    for (auto &[name, indexBlock] : implementations) {
+        auto pass = [&, indexBlock = indexBlock]() { return indexPass(input, indexBlock, index); };
+        speed = measure(pass, input.size(), repetitions, counts);
+        printf("%-24s %10.2f %12zu %12zu\n", ("pre-pass " + name).c_str(), speed, get<0>(counts), get<1>(counts));
+    }
+}
@@ -0,0 +1,1664 @@
+/**
+ * authors: Piotr Krzywicki, Kamil Dubil
+ * date: 16.10.2018
+ */
+
+#include "netlist.h"
+#include "scan.h"
+
+#include <utility>
+#include <vector>
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <set>
+#include <algorithm>
+#include <variant>
+#include <thread>
+#include <charconv>
+#include <cstdint>
+#include <numeric>
+#include <memory>
+#include <tuple>
+#include <stdexcept>
+#include <cstring>
+#include <limits>
+
+#ifdef OBWODY_STATS
+#include <chrono>
+#endif
+
+#ifdef OBWODY_REGEX_PARSER
+#include <regex>
+#include <sstream>
+#include <iterator>
+#endif
+
+// Statistics instrumentation, compiled only with -DOBWODY_STATS
+#ifdef OBWODY_STATS
+#define OBWODY_STAT(...) __VA_ARGS__
+#else
+#define OBWODY_STAT(...)
+#endif
+
+namespace {
+    using namespace std;
+    using namespace obwody;
+
+
+    // Definitions of Element related types and constants
+    inline namespace ElementTraits {
+        // Types
+        using Description = string_view;
+        using DescriptionId = uint32_t;
+        using NodeSlots = array<Node, 3>;
+
+        // Nodes are stored inline, as many of them as nodesMapping says for the type
+        using Element = tuple<ElementType, ElementNo, DescriptionId, NodeSlots>;
+
+        // Raw fields of a syntactically correct line, description pointing into that line
+        using Fields = tuple<ElementType, ElementNo, Description, NodeSlots>;
+
+        // Designator packed into an integer, element type in the upper half and its number in the lower one.
+        // Type and number together take 33 bits, hence 64-bit keys.
+        using ElementKey = uint64_t;
+
+        constexpr ElementKey elementKey(ElementType type, ElementNo number) {
+            return static_cast<ElementKey>(type) << 32 | static_cast<uint32_t>(number);
+        }
+
+        // "Constants"
+        static const unordered_map<ElementType, size_t> nodesMapping {
+                {ElementType::TRANSISTOR,     3},
+                {ElementType::DIODE,          2},
+                {ElementType::RESISTOR,       2},
+                {ElementType::CAPACITOR,      2},
+                {ElementType::VOLTAGE_SOURCE, 2},
+        };
+
+        static const unordered_map<char, ElementType> typesMapping {
+                {'T', ElementType::TRANSISTOR},
+                {'D', ElementType::DIODE},
+                {'R', ElementType::RESISTOR},
+                {'C', ElementType::CAPACITOR},
+                {'E', ElementType::VOLTAGE_SOURCE},
+        };
+
+        static const unordered_map<ElementType, char> inverseTypesMapping {
+                {ElementType::TRANSISTOR,     'T'},
+                {ElementType::DIODE,          'D'},
+                {ElementType::RESISTOR,       'R'},
+                {ElementType::CAPACITOR,      'C'},
+                {ElementType::VOLTAGE_SOURCE, 'E'},
+        };
+    }
+
+    // Basic Joins related types and constants
+    inline namespace JoinTraits {
+        using JoinId = int;
+        constexpr JoinId groundId {0};
+    }
+
+    inline namespace Keys {
+        // Open addressing (linear probing) hash set of designator keys, used to find repetitive ids
+        class KeySet {
+        public:
+            KeySet() : slots(minCapacity, emptySlot), shift(64 - minCapacityBits) {}
+
+            // Returns false if @key was already present
+            bool insert(ElementKey key) {
+                if (2 * (count + 1) > slots.size()) {
+                    grow();
+                }
+                if (!place(key)) return false;
+                ++count;
+                return true;
+            }
+
+            size_t size() const {
+                return count;
+            }
+
+            // Remove all keys, keeping the memory unless it was mostly empty, so that after one large
+            // input clearing costs later small ones their size, not the peak capacity
+            void clear() {
+                if (slots.size() > minCapacity && 8 * count < slots.size()) {
+                    vector<ElementKey>(minCapacity, emptySlot).swap(slots);
+                    shift = 64 - minCapacityBits;
+                } else {
+                    fill(slots.begin(), slots.end(), emptySlot);
+                }
+                count = 0;
+            }
+
+        private:
+            static constexpr ElementKey emptySlot {~ElementKey {0}};
+            static constexpr int minCapacityBits {10};
+            static constexpr size_t minCapacity {size_t {1} << minCapacityBits};
+
+            vector<ElementKey> slots;
+            size_t count {0};
+            int shift;
+
+            // Fibonacci hashing, upper bits of the product are the best mixed ones
+            size_t position(ElementKey key) const {
+                return (key * 0x9E3779B97F4A7C15ull) >> shift;
+            }
+
+            bool place(ElementKey key) {
+                size_t mask {slots.size() - 1};
+                for (size_t i {position(key)};; i = (i + 1) & mask) {
+                    if (slots[i] == key) return false;
+                    if (slots[i] == emptySlot) {
+                        slots[i] = key;
+                        return true;
+                    }
+                }
+            }
+
+            void grow() {
+                vector<ElementKey> old(2 * slots.size(), emptySlot);
+                old.swap(slots);
+                --shift;
+                for (ElementKey key : old) {
+                    if (key != emptySlot) place(key);
+                }
+            }
+        };
+    }
+
+    inline namespace Descriptions {
+        // Interned descriptions, each distinct one stored once in an arena and identified by its index
+        class DescriptionPool {
+        public:
+            DescriptionId intern(Description description) {
+                auto it = ids.find(description);
+                if (it != ids.end()) {
+                    return it->second;
+                }
+
+                Description stored {store(description)};
+                DescriptionId id {static_cast<DescriptionId>(descriptions.size())};
+                descriptions.push_back(stored);
+                ids.emplace(stored, id);
+                return id;
+            }
+
+            Description at(DescriptionId id) const {
+                return descriptions[id];
+            }
+
+            size_t size() const {
+                return descriptions.size();
+            }
+
+            // Remove all descriptions, keeping the first block of the arena
+            void clear() {
+                descriptions.clear();
+                ids.clear();
+                if (blocks.size() > 1) {
+                    blocks.resize(1);
+                }
+                blockNext = blocks.empty() ? nullptr : blocks.front().get();
+                blockFree = blocks.empty() ? 0 : blockSize;
+            }
+
+        private:
+            static constexpr size_t blockSize {1 << 16};
+
+            vector<unique_ptr<char[]>> blocks;
+            char *blockNext {nullptr};
+            size_t blockFree {0};
+            vector<Description> descriptions;
+            unordered_map<Description, DescriptionId> ids;
+
+            // Copy bytes into the arena, descriptions longer than a block get one of their own
+            Description store(Description description) {
+                if (description.size() > blockFree) {
+                    blockFree = max(blockSize, description.size());
+                    blocks.push_back(make_unique<char[]>(blockFree));
+                    blockNext = blocks.back().get();
+                }
+
+                char *begin {blockNext};
+                copy(description.begin(), description.end(), begin);
+                blockNext += description.size();
+                blockFree -= description.size();
+                return {begin, description.size()};
+            }
+        };
+    }
+
+    inline namespace Scanner {
+        constexpr size_t maxTokens {5};
+
+        // Whitespace separated tokens of a line: the first maxTokens of them and how many there are,
+        // counting stops past maxTokens
+        using Tokens = pair<array<string_view, maxTokens>, size_t>;
+
+        constexpr bool isSpace(char c) {
+            return c == ' ' || ('\t' <= c && c <= '\r');
+        }
+
+        // Split @line into @tokens byte by byte, for lines not covered by the vectorized pre-pass
+        void tokenize(string_view line, Tokens &tokens) {
+            auto &[values, count] = tokens;
+            count = 0;
+            for (size_t pos {0}; count <= maxTokens;) {
+                while (pos < line.size() && isSpace(line[pos])) ++pos;
+                if (pos == line.size()) break;
+
+                size_t begin {pos};
+                while (pos < line.size() && !isSpace(line[pos])) ++pos;
+                if (count < maxTokens) values[count] = line.substr(begin, pos - begin);
+                ++count;
+            }
+        }
+
+#ifdef OBWODY_REGEX_PARSER
+        // Reference implementation of the grammar, kept for differential testing of the scanner below.
+        // Works on the line itself, ignoring its tokens.
+        bool scanEntry(string_view line, const Tokens &, Fields &fields) {
+            // Regex used to parse lines
+            static std::string regexCommon = R"((?:0|[1-9][0-9]{0,8}))[\s]+([A-Z0-9][a-zA-Z0-9,\-\/]*)((?:[\s]+(?:0|[1-9][0-9]{0,8})))";
+            static std::string notTransistor = R"(^[\s]*([DRCE])" + regexCommon + R"({2})[\s]*$)";
+            static std::string transistor = R"(^[\s]*([T])" + regexCommon + R"({3})[\s]*$)";
+            static regex notTransistorRetrieve(notTransistor);
+            static regex transistorRetrieve(transistor);
+
+            // Actual matching
+            cmatch match;
+            if (!regex_search(line.begin(), line.end(), match, transistorRetrieve) &&
+                !regex_search(line.begin(), line.end(), match, notTransistorRetrieve)) {
+                return false;
+            }
+
+            auto &[type, number, description, slots] = fields;
+            type = typesMapping.at(*match[1].first);
+            from_chars(match[1].first + 1, match[1].second, number);
+            description = string_view(match[2].first, match[2].length());
+
+            stringstream ss(match[3]);
+            copy(istream_iterator<Node> {ss}, istream_iterator<Node> {}, slots.begin());
+            return true;
+        }
+#else
+        constexpr bool isDigit(char c) {
+            return '0' <= c && c <= '9';
+        }
+
+        constexpr bool isUpper(char c) {
+            return 'A' <= c && c <= 'Z';
+        }
+
+        constexpr bool isLower(char c) {
+            return 'a' <= c && c <= 'z';
+        }
+
+        constexpr bool isDescriptionChar(char c) {
+            return isUpper(c) || isLower(c) || isDigit(c) || c == ',' || c == '-' || c == '/';
+        }
+
+        // Number from 0 to 999999999, without leading zeros
+        bool scanNumber(string_view token, int &value) {
+            static constexpr size_t maxDigits {9};
+            if (token.empty() || token.size() > maxDigits || (token[0] == '0' && token.size() > 1)) {
+                return false;
+            }
+
+            value = 0;
+            for (char c : token) {
+                if (!isDigit(c)) {
+                    return false;
+                }
+                value = value * 10 + (c - '0');
+            }
+            return true;
+        }
+
+        // Check tokens of the line, equivalent to the regex grammar of the reference implementation
+        bool scanEntry(string_view, const Tokens &lineTokens, Fields &fields) {
+            const auto &[tokens, count] = lineTokens;
+            if (count == 0 || count > maxTokens) return false;
+
+            auto &[type, number, description, slots] = fields;
+
+            // Designator: element letter followed by its number
+            string_view id {tokens[0]};
+            auto typeIt = typesMapping.find(id[0]);
+            if (typeIt == typesMapping.end() || !scanNumber(id.substr(1), number)) {
+                return false;
+            }
+            type = typeIt->second;
+
+            size_t nodesCount {nodesMapping.at(type)};
+            if (count != 2 + nodesCount) {
+                return false;
+            }
+
+            // Element type description
+            description = tokens[1];
+            if (!isUpper(description[0]) && !isDigit(description[0])) {
+                return false;
+            }
+            if (!all_of(description.begin(), description.end(), isDescriptionChar)) {
+                return false;
+            }
+
+            // Nodes
+            for (size_t i {0}; i < nodesCount; ++i) {
+                if (!scanNumber(tokens[2 + i], slots[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+#endif
+    }
+
+    inline namespace Rejections {
+        enum class Rejection {
+            SYNTAX,
+            SHORTED,
+            REPEATED,
+        };
+
+        // Thrown for lines not describing a correct element
+        class RejectedLine : public invalid_argument {
+        public:
+            explicit RejectedLine(Rejection reason) : invalid_argument {""}, reason(reason) {}
+
+            Rejection reason;
+        };
+    }
+
+    inline namespace Parser {
+        // Parse line on its own, without checking for repetitive ids
+        Element parseElement(string_view line, const Tokens &tokens, DescriptionPool &descriptions) {
+            Fields fields;
+            if (!scanEntry(line, tokens, fields)) {
+                throw RejectedLine {Rejection::SYNTAX};
+            }
+
+            const auto &[type, number, description, slots] = fields;
+
+            // Check nodes for not being the same
+            auto nodesEnd = slots.begin() + nodesMapping.at(type);
+            if (all_of(slots.begin(), nodesEnd, [&](Node node) { return node == slots[0]; })) {
+                throw RejectedLine {Rejection::SHORTED};
+            }
+
+            return {type, number, descriptions.intern(description), slots};
+        }
+
+        // Call @f on subsequent lines of @input together with their (0-based) indices and tokens,
+        // returns number of lines. Input is indexed by the vectorized pre-pass in blocks ending with newlines,
+        // lines longer than a block are split into tokens on their own.
+        template<typename F>
+        int forEachLine(string_view input, F f) {
+            static constexpr size_t blockSize {1 << 16};
+
+            // Kept between calls, which come for every block of streamed input
+            thread_local scan::BlockIndex blockIndex;
+            Tokens tokens;
+            auto &[values, count] = tokens;
+            int index {0};
+            for (size_t begin {0}; begin < input.size();) {
+                size_t end {input.size()};
+                if (end - begin > blockSize) {
+                    end = input.rfind('\n', begin + blockSize - 1);
+                    if (end == string_view::npos || end < begin) {
+                        end = input.find('\n', begin);
+                        if (end == string_view::npos) end = input.size();
+
+                        string_view line {input.substr(begin, end - begin)};
+                        tokenize(line, tokens);
+                        f(line, index++, tokens);
+                        begin = end + 1;
+                        continue;
+                    }
+                    ++end;
+                }
+
+                string_view block {input.substr(begin, end - begin)};
+                scan::indexBlock(block, blockIndex);
+                const uint32_t *boundaries {blockIndex.boundaries.data()};
+                size_t boundaryCount {blockIndex.boundaryCount};
+                if (block.back() != '\n') blockIndex.lineEnds[blockIndex.lineEndCount++] = block.size();
+
+                // Boundaries alternate between beginnings and ends of tokens, the last token of the block
+                // may have no end if the block does not end with a newline
+                size_t boundary {0};
+                uint32_t lineBegin {0};
+                for (size_t line {0}; line < blockIndex.lineEndCount; ++line) {
+                    uint32_t lineEnd {blockIndex.lineEnds[line]};
+                    count = 0;
+                    while (boundary < boundaryCount && boundaries[boundary] < lineEnd) {
+                        uint32_t tokenBegin {boundaries[boundary++]};
+                        uint32_t tokenEnd {boundary < boundaryCount ? boundaries[boundary++] : lineEnd};
+                        if (count < maxTokens) values[count] = block.substr(tokenBegin, tokenEnd - tokenBegin);
+                        ++count;
+                    }
+                    f(block.substr(lineBegin, lineEnd - lineBegin), index++, tokens);
+                    lineBegin = lineEnd + 1;
+                }
+                begin = end;
+            }
+            return index;
+        }
+    }
+
+    inline namespace Parallel {
+        // Lines of a chunk, numbered from 0 within the chunk.
+        // Correct ones come with their elements, which still have to be checked for repetitive ids
+        // and have descriptions interned in the pool of the chunk, others with the reason of rejection.
+        using ChunkLine = tuple<int, string_view, variant<Element, Rejection>>;
+        using Chunk = tuple<vector<ChunkLine>, int, DescriptionPool>;
+
+        // Chunks smaller than that are not worth a thread
+        constexpr size_t minChunkSize {1 << 16};
+
+        // Split @input into at most @count chunks, each but the last ending with a newline
+        vector<string_view> split(string_view input, size_t count) {
+            vector<string_view> chunks;
+            // Rounded up, so that the remainder does not make an extra chunk
+            size_t chunkSize {max((input.size() + count - 1) / count, minChunkSize)};
+
+            for (size_t begin {0}; begin < input.size();) {
+                size_t end {input.size()};
+                if (input.size() - begin > chunkSize) {
+                    end = input.find('\n', begin + chunkSize - 1);
+                    end = (end == string_view::npos ? input.size() : end + 1);
+                }
+                chunks.push_back(input.substr(begin, end - begin));
+                begin = end;
+            }
+
+            return chunks;
+        }
+
+        Chunk parseChunk(string_view chunk) {
+            vector<ChunkLine> lines;
+            DescriptionPool descriptions;
+
+            int count = forEachLine(chunk, [&](string_view line, int index, const Tokens &tokens) {
+                if (line.empty()) return;
+
+                try {
+                    lines.emplace_back(index, line, parseElement(line, tokens, descriptions));
+                } catch (RejectedLine &rejected) {
+                    lines.emplace_back(index, line, rejected.reason);
+                }
+            });
+
+            return {move(lines), count, move(descriptions)};
+        }
+    }
+
+    inline namespace Degrees {
+        // Nodes are below 10^9 < 2^30
+        constexpr int nodeBits {30};
+
+        // LSD radix sort of non-negative nodes, skipping digits above the largest value
+        void radixSort(vector<Node> &nodes, Node maxNode) {
+            static constexpr int digitBits {10};
+            static constexpr size_t digits {size_t {1} << digitBits};
+
+            vector<Node> buffer(nodes.size());
+            for (int shift {0}; shift < nodeBits && (maxNode >> shift) > 0; shift += digitBits) {
+                array<size_t, digits + 1> offsets {};
+                for (Node node : nodes) {
+                    ++offsets[((node >> shift) & (digits - 1)) + 1];
+                }
+                partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+                for (Node node : nodes) {
+                    buffer[offsets[(node >> shift) & (digits - 1)]++] = node;
+                }
+                nodes.swap(buffer);
+            }
+        }
+
+        // Sort terminals, then count runs of equal nodes
+        vector<Node> unconnectedSparse(vector<Node> &terminals, Node maxNode, [[maybe_unused]] size_t &distinct) {
+            radixSort(terminals, maxNode);
+
+            vector<Node> result;
+            if (terminals.empty() || terminals.front() != groundId) {
+                result.push_back(groundId);
+                OBWODY_STAT(++distinct;)
+            }
+            for (size_t begin {0}, end; begin < terminals.size(); begin = end) {
+                for (end = begin + 1; end < terminals.size() && terminals[end] == terminals[begin]; ++end);
+                OBWODY_STAT(++distinct;)
+                if (end - begin < 2) {
+                    result.push_back(terminals[begin]);
+                }
+            }
+            return result;
+        }
+
+        // Two bitmaps indexed by node: connected at least once, connected at least twice
+        vector<Node> unconnectedDense(const vector<Node> &terminals, Node maxNode, [[maybe_unused]] size_t &distinct) {
+            vector<uint64_t> once(maxNode / 64 + 1), twice(maxNode / 64 + 1);
+            for (Node node : terminals) {
+                uint64_t bit {uint64_t {1} << (node % 64)};
+                twice[node / 64] |= once[node / 64] & bit;
+                once[node / 64] |= bit;
+            }
+            once[groundId / 64] |= uint64_t {1} << (groundId % 64);
+
+            vector<Node> result;
+            for (size_t word {0}; word < once.size(); ++word) {
+                OBWODY_STAT(distinct += __builtin_popcountll(once[word]);)
+                for (uint64_t bits {once[word] & ~twice[word]}; bits != 0; bits &= bits - 1) {
+                    result.push_back(static_cast<Node>(64 * word + __builtin_ctzll(bits)));
+                }
+            }
+            return result;
+        }
+
+        // Nodes (always including ground) with fewer than two terminals, in ascending order.
+        // Bitmaps are used when nodes are compact enough for them to be smaller than a sort buffer.
+        // Distinct nodes are counted only for statistics.
+        vector<Node> unconnected(vector<Node> &terminals, [[maybe_unused]] size_t &distinct) {
+            static constexpr size_t denseNodesPerTerminal {16};
+
+            Node maxNode {groundId};
+            for (Node node : terminals) {
+                maxNode = max(maxNode, node);
+            }
+
+            if (static_cast<size_t>(maxNode) / denseNodesPerTerminal <= terminals.size()) {
+                return unconnectedDense(terminals, maxNode, distinct);
+            }
+            return unconnectedSparse(terminals, maxNode, distinct);
+        }
+    }
+
+    inline namespace Numbering {
+        // Distinct nodes of elements in ascending order, numbered by their positions.
+        // Positions are found in buckets of nodes with the same upper bits, about one node per bucket.
+        class NodeNumbering {
+        public:
+            explicit NodeNumbering(const vector<Element> &elements) {
+                Node maxNode {groundId};
+                sorted.reserve(3 * elements.size());
+                for (const auto &[type, number, description, slots] : elements) {
+                    for (size_t i {0}; i < nodesMapping.at(type); ++i) {
+                        sorted.push_back(slots[i]);
+                        maxNode = max(maxNode, slots[i]);
+                    }
+                }
+                radixSort(sorted, maxNode);
+                sorted.erase(unique(sorted.begin(), sorted.end()), sorted.end());
+
+                while ((static_cast<size_t>(maxNode) >> shift) >= sorted.size() && shift < nodeBits) ++shift;
+                buckets.resize((maxNode >> shift) + 2);
+                for (Node node : sorted) {
+                    ++buckets[(node >> shift) + 1];
+                }
+                partial_sum(buckets.begin(), buckets.end(), buckets.begin());
+            }
+
+            const vector<Node> &nodes() const {
+                return sorted;
+            }
+
+            // Position of @node, which has to be a node of the elements
+            uint32_t indexOf(Node node) const {
+                auto begin = sorted.begin() + buckets[node >> shift], end = sorted.begin() + buckets[(node >> shift) + 1];
+                return lower_bound(begin, end, node) - sorted.begin();
+            }
+
+        private:
+            vector<Node> sorted;
+            int shift {0};
+            vector<uint32_t> buckets;
+        };
+    }
+
+    inline namespace Connectivity {
+        // Disjoint sets of indices, with path compression and union by rank
+        class UnionFind {
+        public:
+            explicit UnionFind(size_t size = 0) : parent(size), rank(size) {
+                iota(parent.begin(), parent.end(), 0);
+            }
+
+            // New index in a set of its own
+            uint32_t add() {
+                parent.push_back(parent.size());
+                rank.push_back(0);
+                return parent.back();
+            }
+
+            size_t size() const {
+                return parent.size();
+            }
+
+            uint32_t find(uint32_t index) {
+                uint32_t root {index};
+                while (parent[root] != root) root = parent[root];
+                while (parent[index] != root) {
+                    index = exchange(parent[index], root);
+                }
+                return root;
+            }
+
+            // Root of the united set
+            uint32_t unite(uint32_t a, uint32_t b) {
+                a = find(a);
+                b = find(b);
+                if (a == b) return a;
+                if (rank[a] < rank[b]) swap(a, b);
+                parent[b] = a;
+                if (rank[a] == rank[b]) ++rank[a];
+                return a;
+            }
+
+            void clear() {
+                parent.clear();
+                rank.clear();
+            }
+
+        private:
+            vector<uint32_t> parent;
+            // Below 32, as a tree of rank r has at least 2^r indices
+            vector<uint8_t> rank;
+        };
+
+        // Groups of nodes connected by elements, but not to ground, each in ascending order and ordered by
+        // their smallest nodes. Group i takes @groups from @ends[i - 1] (0 for the first one) to @ends[i].
+        void floating(const vector<Element> &elements, vector<Node> &groups, vector<size_t> &ends) {
+            // Sets are identified by positions of nodes
+            NodeNumbering numbering {elements};
+            const vector<Node> &nodes {numbering.nodes()};
+            auto indexOf = [&](Node node) { return numbering.indexOf(node); };
+
+            UnionFind sets {nodes.size()};
+            for (const auto &[type, number, description, slots] : elements) {
+                uint32_t first {indexOf(slots[0])};
+                for (size_t i {1}; i < nodesMapping.at(type); ++i) {
+                    sets.unite(first, indexOf(slots[i]));
+                }
+            }
+
+            // Number groups in order of their smallest nodes, skipping that of ground, then place nodes by groups
+            static constexpr uint32_t unnumbered {~uint32_t {0}};
+            bool grounded {!nodes.empty() && nodes.front() == groundId};
+            uint32_t groundRoot {grounded ? sets.find(0) : unnumbered};
+
+            vector<uint32_t> numbers(nodes.size(), unnumbered);
+            ends.clear();
+            for (uint32_t i {0}; i < nodes.size(); ++i) {
+                uint32_t root {sets.find(i)};
+                if (root == groundRoot) continue;
+                if (numbers[root] == unnumbered) {
+                    numbers[root] = ends.size();
+                    ends.push_back(0);
+                }
+                ++ends[numbers[root]];
+            }
+            partial_sum(ends.begin(), ends.end(), ends.begin());
+
+            groups.resize(ends.empty() ? 0 : ends.back());
+            for (uint32_t i = nodes.size(); i-- > 0;) {
+                uint32_t root {sets.find(i)};
+                if (root != groundRoot) {
+                    groups[--ends[numbers[root]]] = nodes[i];
+                }
+            }
+            // Ends were moved to beginnings, shift them by one group
+            ends.push_back(groups.size());
+            ends.erase(ends.begin());
+        }
+    }
+
+#ifdef OBWODY_STATS
+    inline namespace Timing {
+        // Adds wall time of its lifetime to @seconds
+        class ScopedTimer {
+        public:
+            explicit ScopedTimer(double &seconds) : seconds(seconds), start(chrono::steady_clock::now()) {}
+
+            ScopedTimer(const ScopedTimer &) = delete;
+
+            ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+            ~ScopedTimer() {
+                seconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            }
+
+        private:
+            double &seconds;
+            chrono::steady_clock::time_point start;
+        };
+    }
+#endif
+
+    inline namespace Billing {
+        // Element numbers grouped in contiguous runs of the same type and description,
+        // and rows (type, first number, description, run begin, run end) in the order they are shown
+        using BillEntry = tuple<ElementType, DescriptionId, ElementNo>;
+        using BillRow = tuple<ElementType, ElementNo, DescriptionId, size_t, size_t>;
+        using Bill = pair<vector<ElementNo>, vector<BillRow>>;
+
+        // Sort entries once, so that groups come out as runs with ascending numbers,
+        // then order groups by type and their smallest number
+        void groupBill(vector<BillEntry> &entries, Bill &bill) {
+            sort(entries.begin(), entries.end());
+
+            auto &[numbers, rows] = bill;
+            numbers.clear();
+            rows.clear();
+            numbers.reserve(entries.size());
+            for (size_t begin {0}, end; begin < entries.size(); begin = end) {
+                const auto &[type, description, first] = entries[begin];
+                for (end = begin; end < entries.size() && get<ElementType>(entries[end]) == type &&
+                                  get<DescriptionId>(entries[end]) == description; ++end) {
+                    numbers.push_back(get<ElementNo>(entries[end]));
+                }
+                rows.emplace_back(type, first, description, begin, end);
+            }
+            sort(rows.begin(), rows.end());
+        }
+    }
+
+    inline namespace Incremental {
+        // Numbers of elements of one type and description, ascending up to @sorted, in order of lines after it
+        struct BillGroup {
+            ElementType type;
+            DescriptionId description;
+            vector<ElementNo> numbers;
+            size_t sorted {0};
+
+            // Sort numbers added since the last call, merging them into the sorted ones
+            void sortAdded() {
+                sort(numbers.begin() + sorted, numbers.end());
+                inplace_merge(numbers.begin(), numbers.begin() + sorted, numbers.end());
+                sorted = numbers.size();
+            }
+        };
+
+        // Bill groups and degrees of nodes, updated element by element, so that a report costs
+        // as much as its output and elements added since the previous one, not as much as the whole netlist.
+        // Groups of connected nodes are updated only when asked for, with elements added since then.
+        class IncrementalReport {
+        public:
+            void add(const Element &element) {
+                const auto &[type, number, description, nodes] = element;
+
+                auto[it, inserted] = groupIndex.try_emplace(elementKey(type, description), groups.size());
+                if (inserted) {
+                    groups.push_back({type, description, {}, 0});
+                }
+                groups[it->second].numbers.push_back(number);
+
+                // Each node once per element
+                auto nodesEnd = nodes.begin() + nodesMapping.at(type);
+                for (auto node = nodes.begin(); node != nodesEnd; ++node) {
+                    if (find(nodes.begin(), node, *node) != node) continue;
+
+                    uint32_t degree {++degrees[*node]};
+                    if (degree == 1) loose.insert(*node);
+                    if (degree == 2) loose.erase(*node);
+                }
+            }
+
+            // Groups in the order of the bill: by type, then by the smallest number
+            const vector<BillGroup *> &bill() {
+                ordered.clear();
+                for (BillGroup &group : groups) {
+                    group.sortAdded();
+                    ordered.push_back(&group);
+                }
+                sort(ordered.begin(), ordered.end(), [](const BillGroup *a, const BillGroup *b) {
+                    return make_pair(a->type, a->numbers.front()) < make_pair(b->type, b->numbers.front());
+                });
+                return ordered;
+            }
+
+            // Nodes (always including ground) with fewer than two terminals, in ascending order
+            vector<Node> unconnected() const {
+                vector<Node> result;
+                if (degrees.count(groundId) == 0) {
+                    result.push_back(groundId);
+                }
+                result.insert(result.end(), loose.begin(), loose.end());
+                return result;
+            }
+
+            // Distinct nodes, ground included
+            size_t nodes() const {
+                return degrees.size() + (degrees.count(groundId) == 0 ? 1 : 0);
+            }
+
+            // Same as Connectivity::floating() of @elements, all those added so far
+            void floating(const vector<Element> &elements, vector<Node> &groups, vector<size_t> &ends) {
+                for (; joined < elements.size(); ++joined) {
+                    const auto &[type, number, description, slots] = elements[joined];
+                    uint32_t first {positionOf(slots[0])};
+                    for (size_t i {1}; i < nodesMapping.at(type); ++i) {
+                        join(first, positionOf(slots[i]));
+                    }
+                }
+
+                auto ground = positions.find(groundId);
+                uint32_t groundRoot {ground == positions.end() ? ~uint32_t {0} : sets.find(ground->second)};
+                groups.clear();
+                ends.clear();
+                for (auto[smallest, root] : bySmallest) {
+                    if (root == groundRoot) continue;
+                    size_t begin {groups.size()};
+                    uint32_t position {root};
+                    do {
+                        groups.push_back(positionNodes[position]);
+                        position = nextPositions[position];
+                    } while (position != root);
+                    sort(groups.begin() + begin, groups.end());
+                    ends.push_back(groups.size());
+                }
+            }
+
+            void clear() {
+                groupIndex.clear();
+                groups.clear();
+                ordered.clear();
+                degrees.clear();
+                loose.clear();
+                joined = 0;
+                sets.clear();
+                positions.clear();
+                positionNodes.clear();
+                nextPositions.clear();
+                smallestNodes.clear();
+                bySmallest.clear();
+            }
+
+        private:
+            // Groups by type and description (packed like designators)
+            unordered_map<ElementKey, size_t> groupIndex;
+            vector<BillGroup> groups;
+            vector<BillGroup *> ordered;
+
+            // Nodes by number of elements connected to them, those connected to just one element
+            unordered_map<Node, uint32_t> degrees;
+            set<Node> loose;
+
+            // Sets of positions of nodes connected by the first @joined elements. Positions of each set
+            // form a cycle of nextPositions, and sets are ordered by their smallest nodes (kept for roots).
+            size_t joined {0};
+            UnionFind sets;
+            unordered_map<Node, uint32_t> positions;
+            vector<Node> positionNodes;
+            vector<uint32_t> nextPositions;
+            vector<Node> smallestNodes;
+            set<pair<Node, uint32_t>> bySmallest;
+
+            uint32_t positionOf(Node node) {
+                auto[it, inserted] = positions.try_emplace(node, sets.size());
+                if (inserted) {
+                    sets.add();
+                    positionNodes.push_back(node);
+                    nextPositions.push_back(it->second);
+                    smallestNodes.push_back(node);
+                    bySmallest.emplace(node, it->second);
+                }
+                return it->second;
+            }
+
+            void join(uint32_t a, uint32_t b) {
+                a = sets.find(a);
+                b = sets.find(b);
+                if (a == b) return;
+                uint32_t root {sets.unite(a, b)};
+                bySmallest.erase({smallestNodes[a], a});
+                bySmallest.erase({smallestNodes[b], b});
+                smallestNodes[root] = min(smallestNodes[a], smallestNodes[b]);
+                bySmallest.emplace(smallestNodes[root], root);
+                // Splice the two cycles into one
+                swap(nextPositions[a], nextPositions[b]);
+            }
+        };
+    }
+
+    // Binary netlists, all integers in native byte order:
+    // header, packed elements, rejected lines, ends of strings, bytes of strings.
+    // Strings are descriptions (indexed by DescriptionId) followed by texts of rejected lines.
+    inline namespace Binary {
+        constexpr uint32_t binaryVersion {1};
+
+        struct BinaryHeader {
+            array<char, 8> magic;
+            uint32_t version;
+            uint32_t lineCount;
+            uint32_t elementCount;
+            uint32_t rejectedCount;
+            uint32_t descriptionCount;
+            uint32_t reserved;
+        };
+
+        // Type in the upper bits of the description id, nodes past those of the type are 0
+        struct PackedElement {
+            uint32_t number;
+            uint32_t typeAndDescription;
+            NodeSlots nodes;
+        };
+
+        struct RejectedRecord {
+            uint32_t lineNumber;
+            uint32_t reason;
+        };
+
+        using StringEnd = uint64_t;
+
+        constexpr int typeShift {29};
+        constexpr uint32_t maxDescriptions {uint32_t {1} << typeShift};
+        constexpr Node maxNode {999999999};
+
+        template<typename T>
+        void append(string &image, const T &value) {
+            image.append(reinterpret_cast<const char *>(&value), sizeof(T));
+        }
+
+        // Reads consecutive values and sections of an image, throwing if it ends too early
+        class ImageReader {
+        public:
+            explicit ImageReader(string_view image) : image(image) {}
+
+            string_view take(size_t count, size_t size) {
+                if (size != 0 && count > (image.size() - position) / size) {
+                    throw invalid_argument {"truncated binary netlist"};
+                }
+                string_view section {image.substr(position, count * size)};
+                position += count * size;
+                return section;
+            }
+
+            string_view rest() {
+                return take(image.size() - position, 1);
+            }
+
+            // Value number @index of a section taken for values of type T
+            template<typename T>
+            static T at(string_view section, size_t index) {
+                T value;
+                memcpy(&value, section.data() + index * sizeof(T), sizeof(T));
+                return value;
+            }
+
+        private:
+            string_view image;
+            size_t position {0};
+        };
+    }
+
+    // Net indexes, in compressed sparse row form, all integers in native byte order: header,
+    // distinct nodes ascending, offsets of their elements, elements of nodes (ascending positions of elements),
+    // designators of elements ascending, offsets of their nodes, nodes of elements (in order of their lines).
+    inline namespace Indexing {
+        constexpr uint32_t indexVersion {1};
+        constexpr array<char, 8> indexMagic {'\x7F', 'O', 'B', 'W', 'I', 'D', 'X', '\n'};
+
+        struct IndexHeader {
+            array<char, 8> magic;
+            uint32_t version;
+            uint32_t nodeCount;
+            uint32_t elementCount;
+            uint32_t terminalCount;
+        };
+
+        template<typename T>
+        void appendAll(string &image, const vector<T> &values) {
+            image.append(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+        }
+
+        // Index of which elements touch which nodes, each node counted once per element
+        string buildIndex(const vector<Element> &elements) {
+            if (3 * elements.size() > numeric_limits<uint32_t>::max()) {
+                throw length_error {"too many elements for a net index"};
+            }
+
+            NodeNumbering numbering {elements};
+            const vector<Node> &nodes {numbering.nodes()};
+
+            // Elements ordered by designators
+            vector<pair<ElementKey, uint32_t>> designators;
+            designators.reserve(elements.size());
+            for (uint32_t i {0}; i < elements.size(); ++i) {
+                designators.emplace_back(elementKey(get<ElementType>(elements[i]), get<ElementNo>(elements[i])), i);
+            }
+            sort(designators.begin(), designators.end());
+
+            // Element to nodes, counting elements of nodes on the way
+            vector<ElementKey> keys;
+            vector<uint32_t> elementOffsets {0}, terminals, nodeOffsets(nodes.size() + 1);
+            keys.reserve(elements.size());
+            terminals.reserve(3 * elements.size());
+            for (const auto &[key, position] : designators) {
+                const auto &[type, number, description, slots] = elements[position];
+                auto slotsEnd = slots.begin() + nodesMapping.at(type);
+                for (auto slot = slots.begin(); slot != slotsEnd; ++slot) {
+                    if (find(slots.begin(), slot, *slot) != slot) continue;
+                    uint32_t index {numbering.indexOf(*slot)};
+                    terminals.push_back(index);
+                    ++nodeOffsets[index + 1];
+                }
+                keys.push_back(key);
+                elementOffsets.push_back(terminals.size());
+            }
+            partial_sum(nodeOffsets.begin(), nodeOffsets.end(), nodeOffsets.begin());
+
+            // Node to elements, placing elements in order, so that they come out ascending
+            vector<uint32_t> nodeElements(terminals.size()), next(nodeOffsets.begin(), nodeOffsets.end() - 1);
+            for (uint32_t element {0}; element < keys.size(); ++element) {
+                for (uint32_t i {elementOffsets[element]}; i < elementOffsets[element + 1]; ++i) {
+                    nodeElements[next[terminals[i]]++] = element;
+                }
+            }
+            for (uint32_t &terminal : terminals) {
+                terminal = nodes[terminal];
+            }
+
+            IndexHeader header {indexMagic, indexVersion, static_cast<uint32_t>(nodes.size()),
+                                static_cast<uint32_t>(keys.size()), static_cast<uint32_t>(terminals.size())};
+            string image;
+            append(image, header);
+            appendAll(image, nodes);
+            appendAll(image, nodeOffsets);
+            appendAll(image, nodeElements);
+            appendAll(image, keys);
+            appendAll(image, elementOffsets);
+            appendAll(image, terminals);
+            return image;
+        }
+    }
+}
+
+namespace obwody {
+    using namespace std;
+
+    char elementLetter(ElementType type) {
+        return inverseTypesMapping.at(type);
+    }
+
+    class NetlistAnalyzer::State {
+    public:
+        ErrorCallback onError;
+        BillRowCallback onBillRow;
+        UnconnectedCallback onUnconnected;
+        FloatingCallback onFloating;
+        size_t jobs {1};
+
+        // Correct elements so far, their designators and descriptions
+        vector<Element> elements;
+        KeySet ids;
+        DescriptionPool descriptions;
+        int lineCount {0};
+
+        // Buffers of report, kept between netlists
+        vector<JoinId> joins;
+        vector<BillEntry> entries;
+        Bill bill;
+        vector<Node> floatingGroups;
+        vector<size_t> floatingEnds;
+
+        // Net index of the last report, built only if asked for
+        bool indexing {false};
+        string indexImage;
+
+        // Kept up to date only in the incremental mode
+        bool incremental {false};
+        IncrementalReport incrementalReport;
+
+        // While compiling, rejected lines are recorded with ends of their texts in rejectedText
+        bool compiling {false};
+        vector<tuple<int, Rejection, size_t>> rejected;
+        string rejectedText;
+
+        OBWODY_STAT(Statistics statistics;)
+
+        State(ErrorCallback &&onError, BillRowCallback &&onBillRow, UnconnectedCallback &&onUnconnected) :
+                onError(move(onError)), onBillRow(move(onBillRow)), onUnconnected(move(onUnconnected)) {}
+
+        // Accept element unless its id has already been used
+        void addElement(Element &&element) {
+            if (!ids.insert(elementKey(get<ElementType>(element), get<ElementNo>(element)))) {
+                throw RejectedLine {Rejection::REPEATED};
+            }
+            elements.push_back(move(element));
+            if (incremental) {
+                incrementalReport.add(elements.back());
+            }
+        }
+
+        void setIncremental(bool enabled) {
+            incremental = enabled;
+            incrementalReport.clear();
+            if (incremental) {
+                for (const Element &element : elements) {
+                    incrementalReport.add(element);
+                }
+            }
+        }
+
+        void reject(string_view line, int lineNumber, [[maybe_unused]] Rejection reason) {
+            OBWODY_STAT(
+                switch (reason) {
+                    case Rejection::SYNTAX: ++statistics.syntaxErrors; break;
+                    case Rejection::SHORTED: ++statistics.shortedElements; break;
+                    case Rejection::REPEATED: ++statistics.repeatedDesignators; break;
+                }
+            )
+            if (compiling) {
+                rejectedText += line;
+                rejected.emplace_back(lineNumber, reason, rejectedText.size());
+            } else {
+                onError(line, lineNumber);
+            }
+        }
+
+        // Parse single line split into @tokens, logging it in case of error
+        void parseLine(string_view line, const Tokens &tokens, int lineNumber) {
+            if (line.empty()) return;
+
+            try {
+                addElement(parseElement(line, tokens, descriptions));
+            } catch (RejectedLine &rejected) {
+                reject(line, lineNumber, rejected.reason);
+            }
+        }
+
+        // Parse chunks of @input on up to @jobs threads, then merge them in line order,
+        // so that errors are logged and repetitive ids are detected exactly as in the sequential case
+        void parseChunks(const vector<string_view> &chunks) {
+            vector<Chunk> parsed(chunks.size());
+            vector<thread> workers;
+            for (size_t i {0}; i < chunks.size(); ++i) {
+                workers.emplace_back([&, i]() { parsed[i] = parseChunk(chunks[i]); });
+            }
+            for (thread &worker : workers) {
+                worker.join();
+            }
+
+            for (auto &[lines, count, chunkDescriptions] : parsed) {
+                // Translate ids from the pool of the chunk
+                vector<DescriptionId> translated(chunkDescriptions.size());
+                for (DescriptionId id {0}; id < translated.size(); ++id) {
+                    translated[id] = descriptions.intern(chunkDescriptions.at(id));
+                }
+
+                for (auto &[index, line, parsed] : lines) {
+                    if (auto reason = get_if<Rejection>(&parsed)) {
+                        reject(line, lineCount + 1 + index, *reason);
+                        continue;
+                    }
+                    try {
+                        Element &element {get<Element>(parsed)};
+                        get<DescriptionId>(element) = translated[get<DescriptionId>(element)];
+                        addElement(move(element));
+                    } catch (RejectedLine &rejected) {
+                        reject(line, lineCount + 1 + index, rejected.reason);
+                    }
+                }
+                lineCount += count;
+                lines = {};
+                chunkDescriptions = {};
+            }
+        }
+
+        void parseLines(string_view input) {
+            OBWODY_STAT(ScopedTimer timer {statistics.readSeconds};)
+
+            vector<string_view> chunks;
+            if (jobs > 1) {
+                chunks = split(input, jobs);
+            }
+
+            if (chunks.size() > 1) {
+                parseChunks(chunks);
+            } else {
+                parseInOrder(input);
+            }
+        }
+
+        void parseInOrder(string_view input) {
+            lineCount += forEachLine(input, [&](string_view line, int index, const Tokens &tokens) {
+                parseLine(line, tokens, lineCount + 1 + index);
+            });
+        }
+
+        void reportIncremental() {
+            OBWODY_STAT(statistics.lines = lineCount;)
+
+            const vector<BillGroup *> *groups;
+            {
+                OBWODY_STAT(ScopedTimer timer {statistics.joinsAndBillSeconds};)
+                groups = &incrementalReport.bill();
+            }
+
+            {
+                OBWODY_STAT(ScopedTimer timer {statistics.billingSeconds};)
+
+                for (const BillGroup *group : *groups) {
+                    const vector<ElementNo> &numbers {group->numbers};
+                    onBillRow(group->type, numbers.data(), numbers.data() + numbers.size(),
+                              descriptions.at(group->description));
+                }
+
+                OBWODY_STAT(
+                    vector<bool> used(descriptions.size());
+                    for (const BillGroup *group : *groups) {
+                        used[group->description] = true;
+                    }
+                    statistics.descriptions = count(used.begin(), used.end(), true);
+                )
+            }
+
+            {
+                OBWODY_STAT(ScopedTimer timer {statistics.unconnectedSeconds};)
+
+                vector<Node> unconnectedNodes {incrementalReport.unconnected()};
+                OBWODY_STAT(statistics.nodes = incrementalReport.nodes();)
+                if (!unconnectedNodes.empty()) {
+                    onUnconnected(unconnectedNodes);
+                }
+            }
+
+            reportFloating();
+            reportIndex();
+        }
+
+        void report() {
+            if (incremental) {
+                reportIncremental();
+                return;
+            }
+
+            OBWODY_STAT(statistics.lines = lineCount;)
+
+            {
+                OBWODY_STAT(ScopedTimer timer {statistics.joinsAndBillSeconds};)
+
+                // Gather terminals, each node once per element
+                // And group ids by type and description
+                joins.clear();
+                entries.clear();
+                joins.reserve(3 * elements.size());
+                entries.reserve(elements.size());
+                for (const Element &element : elements) {
+                    const auto&[type, number, description, nodes] = element;
+                    auto nodesEnd = nodes.begin() + nodesMapping.at(type);
+                    for (auto it = nodes.begin(); it != nodesEnd; ++it) {
+                        if (find(nodes.begin(), it, *it) == it) {
+                            joins.push_back(*it);
+                        }
+                    }
+                    entries.emplace_back(type, description, number);
+                }
+                groupBill(entries, bill);
+            }
+
+            {
+                OBWODY_STAT(ScopedTimer timer {statistics.billingSeconds};)
+
+                const auto &[numbers, rows] = bill;
+                for (const auto &[type, first, description, begin, end] : rows) {
+                    onBillRow(type, numbers.data() + begin, numbers.data() + end, descriptions.at(description));
+                }
+
+                // Pool holds also descriptions of lines rejected for repeated designators
+                OBWODY_STAT(
+                    vector<bool> used(descriptions.size());
+                    for (const BillRow &row : rows) {
+                        used[get<DescriptionId>(row)] = true;
+                    }
+                    statistics.descriptions = count(used.begin(), used.end(), true);
+                )
+            }
+
+            {
+                OBWODY_STAT(ScopedTimer timer {statistics.unconnectedSeconds};)
+
+                size_t distinct {0};
+                vector<JoinId> unconnectedJoins {unconnected(joins, distinct)};
+                OBWODY_STAT(statistics.nodes = distinct;)
+                if (!unconnectedJoins.empty()) {
+                    onUnconnected(unconnectedJoins);
+                }
+            }
+
+            reportFloating();
+            reportIndex();
+        }
+
+        void reportIndex() {
+            if (!indexing) return;
+            OBWODY_STAT(ScopedTimer timer {statistics.indexSeconds};)
+
+            indexImage = buildIndex(elements);
+        }
+
+        // Optional pass, only if there is a callback for it
+        void reportFloating() {
+            if (!onFloating) return;
+            OBWODY_STAT(ScopedTimer timer {statistics.floatingSeconds};)
+
+            if (incremental) {
+                incrementalReport.floating(elements, floatingGroups, floatingEnds);
+            } else {
+                floating(elements, floatingGroups, floatingEnds);
+            }
+            OBWODY_STAT(statistics.floatingGroups = floatingEnds.size();)
+            const Node *begin {floatingGroups.data()};
+            for (size_t end : floatingEnds) {
+                onFloating(begin, floatingGroups.data() + end);
+                begin = floatingGroups.data() + end;
+            }
+        }
+
+        // Binary form of lines given so far, see Binary
+        string save() const {
+            if (descriptions.size() >= maxDescriptions) {
+                throw length_error {"too many descriptions for a binary netlist"};
+            }
+
+            BinaryHeader header {};
+            header.magic = {'\x7F', 'O', 'B', 'W', 'O', 'D', 'Y', '\n'};
+            header.version = binaryVersion;
+            header.lineCount = lineCount;
+            header.elementCount = elements.size();
+            header.rejectedCount = rejected.size();
+            header.descriptionCount = descriptions.size();
+
+            string image;
+            append(image, header);
+            for (const auto &[type, number, description, nodes] : elements) {
+                PackedElement packed {};
+                packed.number = number;
+                packed.typeAndDescription = static_cast<uint32_t>(type) << typeShift | description;
+                copy_n(nodes.begin(), nodesMapping.at(type), packed.nodes.begin());
+                append(image, packed);
+            }
+            for (const auto &[lineNumber, reason, end] : rejected) {
+                append(image, RejectedRecord {static_cast<uint32_t>(lineNumber), static_cast<uint32_t>(reason)});
+            }
+
+            StringEnd end {0};
+            for (DescriptionId id {0}; id < descriptions.size(); ++id) {
+                append(image, end += descriptions.at(id).size());
+            }
+            for (const auto &[lineNumber, reason, textEnd] : rejected) {
+                append(image, end + textEnd);
+            }
+            for (DescriptionId id {0}; id < descriptions.size(); ++id) {
+                image += descriptions.at(id);
+            }
+            image += rejectedText;
+            return image;
+        }
+
+        // Take lines of a binary netlist, reporting its rejected lines. Only the fixed-size records
+        // are checked and copied, lines are not parsed again.
+        void load(string_view image) {
+            auto corrupted = []() { return invalid_argument {"corrupted binary netlist"}; };
+
+            ImageReader reader {image};
+            auto header = ImageReader::at<BinaryHeader>(reader.take(1, sizeof(BinaryHeader)), 0);
+            if (string_view {header.magic.data(), header.magic.size()} != compiledMagic ||
+                header.version != binaryVersion || header.descriptionCount >= maxDescriptions) {
+                throw corrupted();
+            }
+
+            string_view packedElements {reader.take(header.elementCount, sizeof(PackedElement))};
+            string_view records {reader.take(header.rejectedCount, sizeof(RejectedRecord))};
+            string_view ends {reader.take(header.descriptionCount + size_t {header.rejectedCount}, sizeof(StringEnd))};
+            string_view strings {reader.rest()};
+
+            StringEnd begin {0};
+            auto nextString = [&](size_t index) {
+                StringEnd end {ImageReader::at<StringEnd>(ends, index)};
+                if (end < begin || end > strings.size()) throw corrupted();
+                string_view result {strings.substr(begin, end - begin)};
+                begin = end;
+                return result;
+            };
+
+            for (DescriptionId id {0}; id < header.descriptionCount; ++id) {
+                if (descriptions.intern(nextString(id)) != id) throw corrupted();
+            }
+
+            // Reported only once the whole image is known to be correct
+            vector<string_view> rejectedLines(header.rejectedCount);
+            for (size_t i {0}; i < header.rejectedCount; ++i) {
+                if (ImageReader::at<RejectedRecord>(records, i).reason > static_cast<uint32_t>(Rejection::REPEATED)) {
+                    throw corrupted();
+                }
+                rejectedLines[i] = nextString(header.descriptionCount + i);
+            }
+
+            elements.reserve(header.elementCount);
+            for (size_t i {0}; i < header.elementCount; ++i) {
+                auto[number, typeAndDescription, nodes] = ImageReader::at<PackedElement>(packedElements, i);
+                uint32_t type {typeAndDescription >> typeShift};
+                DescriptionId description {typeAndDescription & (maxDescriptions - 1)};
+                if (type > static_cast<uint32_t>(ElementType::VOLTAGE_SOURCE) || number > uint32_t {maxNode} ||
+                    description >= header.descriptionCount ||
+                    any_of(nodes.begin(), nodes.end(), [](Node node) { return node < 0 || node > maxNode; })) {
+                    throw corrupted();
+                }
+                // Remembered for lines added later, as designators of parsed lines are; no image has repeated ones
+                if (!ids.insert(elementKey(static_cast<ElementType>(type), number))) throw corrupted();
+                elements.emplace_back(static_cast<ElementType>(type), number, description, nodes);
+                if (incremental) {
+                    incrementalReport.add(elements.back());
+                }
+            }
+
+            for (size_t i {0}; i < header.rejectedCount; ++i) {
+                auto[lineNumber, reason] = ImageReader::at<RejectedRecord>(records, i);
+                reject(rejectedLines[i], lineNumber, static_cast<Rejection>(reason));
+            }
+            lineCount = header.lineCount;
+        }
+
+        void reset() {
+            elements.clear();
+            ids.clear();
+            descriptions.clear();
+            rejected.clear();
+            rejectedText.clear();
+            incrementalReport.clear();
+            indexImage.clear();
+            lineCount = 0;
+            OBWODY_STAT(statistics = {};)
+        }
+    };
+
+    NetlistAnalyzer::NetlistAnalyzer(ErrorCallback onError, BillRowCallback onBillRow,
+                                     UnconnectedCallback onUnconnected) :
+            state(make_unique<State>(move(onError), move(onBillRow), move(onUnconnected))) {}
+
+    NetlistAnalyzer::NetlistAnalyzer(NetlistAnalyzer &&) noexcept = default;
+
+    NetlistAnalyzer &NetlistAnalyzer::operator=(NetlistAnalyzer &&) noexcept = default;
+
+    NetlistAnalyzer::~NetlistAnalyzer() = default;
+
+    void NetlistAnalyzer::setJobs(size_t jobs) {
+        state->jobs = (jobs == 0 ? max(1u, thread::hardware_concurrency()) : jobs);
+    }
+
+    void NetlistAnalyzer::setFloatingCallback(FloatingCallback onFloating) {
+        state->onFloating = move(onFloating);
+    }
+
+    void NetlistAnalyzer::setIndexing(bool indexing) {
+        state->indexing = indexing;
+    }
+
+    const string &NetlistAnalyzer::index() const {
+        return state->indexImage;
+    }
+
+    void NetlistAnalyzer::setIncremental(bool incremental) {
+        state->setIncremental(incremental);
+    }
+
+    void NetlistAnalyzer::analyze(string_view netlist) {
+        reset();
+        addLines(netlist);
+        report();
+    }
+
+    void NetlistAnalyzer::analyze(istream &netlist) {
+        reset();
+        {
+            OBWODY_STAT(ScopedTimer timer {state->statistics.readSeconds};)
+
+            // Read in blocks, so that complete lines go through the vectorized pre-pass
+            static constexpr size_t blockSize {1 << 16};
+            string buffer;
+            size_t parsed {0};
+            do {
+                buffer.erase(0, parsed);
+                size_t size {buffer.size()};
+                buffer.resize(size + blockSize);
+                netlist.read(buffer.data() + size, blockSize);
+                buffer.resize(size + netlist.gcount());
+
+                parsed = buffer.rfind('\n') + 1;
+                state->parseInOrder(string_view {buffer}.substr(0, netlist ? parsed : buffer.size()));
+            } while (netlist);
+        }
+        report();
+    }
+
+    string NetlistAnalyzer::compile(string_view netlist) {
+        reset();
+        state->compiling = true;
+        addLines(netlist);
+        state->compiling = false;
+        return state->save();
+    }
+
+    void NetlistAnalyzer::analyzeCompiled(string_view image) {
+        reset();
+        {
+            OBWODY_STAT(ScopedTimer timer {state->statistics.readSeconds};)
+
+            // A rejected image leaves nothing of itself behind
+            try {
+                state->load(image);
+            } catch (...) {
+                reset();
+                throw;
+            }
+        }
+        report();
+    }
+
+    void NetlistAnalyzer::addLine(string_view line) {
+        Tokens tokens;
+        tokenize(line, tokens);
+        state->parseLine(line, tokens, ++state->lineCount);
+    }
+
+    void NetlistAnalyzer::addLines(string_view lines) {
+        state->parseLines(lines);
+    }
+
+    void NetlistAnalyzer::report() {
+        state->report();
+    }
+
+    void NetlistAnalyzer::reset() {
+        state->reset();
+    }
+
+#ifdef OBWODY_STATS
+    const Statistics &NetlistAnalyzer::statistics() const {
+        return state->statistics;
+    }
+#endif
+
+    namespace {
+        invalid_argument corruptedIndex() {
+            return invalid_argument {"corrupted net index"};
+        }
+
+        // Value number @index of a section of an index, which is corrupted if there is no such value
+        template<typename T>
+        T valueAt(string_view section, size_t index) {
+            if (index >= section.size() / sizeof(T)) throw corruptedIndex();
+            return ImageReader::at<T>(section, index);
+        }
+
+        Designator designatorOf(ElementKey key) {
+            if ((key >> 32) > static_cast<ElementKey>(ElementType::VOLTAGE_SOURCE)) throw corruptedIndex();
+            return {static_cast<ElementType>(key >> 32), static_cast<ElementNo>(key & ~uint32_t {0})};
+        }
+
+        // First of @count values of @section not less than @value
+        template<typename T>
+        size_t lowerBound(string_view section, size_t count, T value) {
+            size_t begin {0}, end {count};
+            while (begin < end) {
+                size_t middle {begin + (end - begin) / 2};
+                if (valueAt<T>(section, middle) < value) {
+                    begin = middle + 1;
+                } else {
+                    end = middle;
+                }
+            }
+            return begin;
+        }
+    }
+
+    NetIndex::NetIndex(string_view image) {
+        ImageReader reader {image};
+        auto header = ImageReader::at<IndexHeader>(reader.take(1, sizeof(IndexHeader)), 0);
+        if (header.magic != indexMagic || header.version != indexVersion) {
+            throw corruptedIndex();
+        }
+
+        nodeList = reader.take(header.nodeCount, sizeof(Node));
+        nodeOffsets = reader.take(header.nodeCount + size_t {1}, sizeof(uint32_t));
+        nodeElements = reader.take(header.terminalCount, sizeof(uint32_t));
+        designators = reader.take(header.elementCount, sizeof(ElementKey));
+        elementOffsets = reader.take(header.elementCount + size_t {1}, sizeof(uint32_t));
+        elementNodeList = reader.take(header.terminalCount, sizeof(Node));
+    }
+
+    void NetIndex::nodes(Node first, Node last, const NodeCallback &onNode) const {
+        size_t count {nodeList.size() / sizeof(Node)};
+        vector<Designator> elements;
+        for (size_t i {lowerBound(nodeList, count, first)}; i < count; ++i) {
+            Node node {valueAt<Node>(nodeList, i)};
+            if (node > last) break;
+
+            elements.clear();
+            uint32_t end {valueAt<uint32_t>(nodeOffsets, i + 1)};
+            for (uint32_t terminal {valueAt<uint32_t>(nodeOffsets, i)}; terminal < end; ++terminal) {
+                uint32_t element {valueAt<uint32_t>(nodeElements, terminal)};
+                elements.push_back(designatorOf(valueAt<ElementKey>(designators, element)));
+            }
+            onNode(node, elements);
+        }
+    }
+
+    vector<Node> NetIndex::elementNodes(Designator designator) const {
+        auto[type, number] = designator;
+        ElementKey key {elementKey(type, number)};
+        size_t count {designators.size() / sizeof(ElementKey)};
+        size_t element {lowerBound(designators, count, key)};
+        if (element == count || valueAt<ElementKey>(designators, element) != key) return {};
+
+        vector<Node> nodes;
+        uint32_t end {valueAt<uint32_t>(elementOffsets, element + 1)};
+        for (uint32_t terminal {valueAt<uint32_t>(elementOffsets, element)}; terminal < end; ++terminal) {
+            nodes.push_back(valueAt<Node>(elementNodeList, terminal));
+        }
+        return nodes;
+    }
+}
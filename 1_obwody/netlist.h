@@ -0,0 +1,167 @@
+#ifndef OBWODY_NETLIST_H
+#define OBWODY_NETLIST_H
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <utility>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace obwody {
+
+    using ElementNo = int;
+    using Node = int;
+
+    enum class ElementType {
+        TRANSISTOR = 0,
+        DIODE,
+        RESISTOR,
+        CAPACITOR,
+        VOLTAGE_SOURCE,
+    };
+
+    // Letter starting designators of elements of type @type.
+    char elementLetter(ElementType type);
+
+    // Binary netlists made by NetlistAnalyzer::compile() start with these bytes.
+    inline constexpr std::string_view compiledMagic {"\x7F" "OBWODY\n", 8};
+
+    // Designator of an element: its type and number.
+    using Designator = std::pair<ElementType, ElementNo>;
+
+    // Read-only view of a net index made by NetlistAnalyzer::index(), which has to outlive it.
+    // Lookups take O(log(number of nodes) + size of their result).
+    class NetIndex {
+    public:
+
+        // Elements connected to a node, ordered by designators.
+        using NodeCallback = std::function<void(Node node, const std::vector<Designator> &elements)>;
+
+        // Throws std::invalid_argument if @image is not a net index, lookups throw it if the index is corrupted.
+        explicit NetIndex(std::string_view image);
+
+        // Call @onNode for nodes from @first to @last connected to any element, in ascending order.
+        void nodes(Node first, Node last, const NodeCallback &onNode) const;
+
+        // Nodes of the element @designator, each once, in order of its line. Empty if there is no such element.
+        std::vector<Node> elementNodes(Designator designator) const;
+
+    private:
+
+        std::string_view nodeList, nodeOffsets, nodeElements, designators, elementOffsets, elementNodeList;
+    };
+
+#ifdef OBWODY_STATS
+    // Counters and wall times of an analysis, collected only when compiled with -DOBWODY_STATS.
+    struct Statistics {
+        // Parsing (analyze() and addLines()), grouping, reporting the bill, finding unconnected nodes
+        // and groups of nodes not connected to ground, building the net index (the last two only if asked for)
+        double readSeconds {0};
+        double joinsAndBillSeconds {0};
+        double billingSeconds {0};
+        double unconnectedSeconds {0};
+        double floatingSeconds {0};
+        double indexSeconds {0};
+
+        size_t lines {0};
+
+        // Rejected lines by reason
+        size_t syntaxErrors {0};
+        size_t repeatedDesignators {0};
+        size_t shortedElements {0};
+
+        size_t descriptions {0};
+        size_t nodes {0};
+        size_t floatingGroups {0};
+    };
+#endif
+
+    // Checks netlists line by line, then reports their bill of materials and unconnected nodes,
+    // passing everything to callbacks. One analyzer can be reused for many netlists,
+    // its memory (and memory of its interned descriptions) is kept between them.
+    class NetlistAnalyzer {
+    public:
+
+        // Incorrect line with its original text, lines are numbered from 1.
+        using ErrorCallback = std::function<void(std::string_view line, int lineNumber)>;
+
+        // Row of the bill of materials: type, ascending numbers of elements and their description.
+        using BillRowCallback = std::function<void(ElementType type, const ElementNo *begin, const ElementNo *end,
+                                                   std::string_view description)>;
+
+        // Nodes connected to fewer than two elements, in ascending order. Not called if there are none.
+        using UnconnectedCallback = std::function<void(const std::vector<Node> &nodes)>;
+
+        // Group of nodes connected with each other by elements, but not with ground, in ascending order.
+        using FloatingCallback = std::function<void(const Node *begin, const Node *end)>;
+
+        NetlistAnalyzer(ErrorCallback onError, BillRowCallback onBillRow, UnconnectedCallback onUnconnected);
+
+        NetlistAnalyzer(NetlistAnalyzer &&other) noexcept;
+
+        NetlistAnalyzer &operator=(NetlistAnalyzer &&other) noexcept;
+
+        ~NetlistAnalyzer();
+
+        // Number of threads parsing buffers given to analyze() and addLines(), 0 meaning one per core.
+        void setJobs(size_t jobs);
+
+        // Enable the optional pass reporting groups of nodes not connected with ground, after unconnected nodes,
+        // ordered by their smallest nodes. It takes near-linear time (union-find); an empty callback disables it.
+        void setFloatingCallback(FloatingCallback onFloating);
+
+        // Build a net index (which elements touch which nodes, in compressed sparse row form) in every report().
+        void setIndexing(bool indexing);
+
+        // Net index built by the last report(), a binary image to be saved or read by NetIndex. Empty if none.
+        const std::string &index() const;
+
+        // In the incremental mode the bill, degrees of nodes and groups of connected nodes are kept up to date
+        // as lines are added, so that report() costs as much as its output and lines added since the previous
+        // report, instead of sorting the whole netlist again. Meant for netlists growing between reports,
+        // at the cost of slower adding of lines. The net index is still built from the whole netlist.
+        // Results are the same in both modes.
+        void setIncremental(bool incremental);
+
+        // Analyze a whole netlist: forget the previous one, parse all lines and report.
+        void analyze(std::string_view netlist);
+
+        void analyze(std::istream &netlist);
+
+        // Convert a whole netlist to the binary form read by analyzeCompiled(): interned descriptions,
+        // packed elements with fixed node arrays, and rejected lines, which are recorded instead of reported.
+        // The analyzer is left with the lines of @netlist, as after addLines().
+        std::string compile(std::string_view netlist);
+
+        // Analyze a whole netlist in the binary form made by compile(), reporting exactly what the analysis
+        // of its text would. Throws std::invalid_argument if @image is not a correct binary netlist.
+        void analyzeCompiled(std::string_view image);
+
+        // Parse a line, or all lines of a buffer, numbering them after lines given so far.
+        void addLine(std::string_view line);
+
+        void addLines(std::string_view lines);
+
+        // Report bill of materials and unconnected nodes of lines given so far.
+        void report();
+
+        // Forget lines given so far, keeping allocated memory.
+        void reset();
+
+#ifdef OBWODY_STATS
+        // Statistics of lines given so far, complete after report().
+        const Statistics &statistics() const;
+#endif
+
+    private:
+
+        class State;
+
+        std::unique_ptr<State> state;
+    };
+}
+
+#endif //OBWODY_NETLIST_H
@@ -3,204 +3,805 @@
  * date: 16.10.2018
  */
 
-#include <utility>
+#include "netlist.h"
+
 #include <iostream>
+#include <fstream>
+#include <iterator>
 #include <vector>
-#include <sstream>
-#include <unordered_map>
-#include <regex>
-#include <set>
-#include <unordered_set>
+#include <array>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <charconv>
+#include <system_error>
+#include <cerrno>
+#include <limits>
+#include <type_traits>
+#include <tuple>
+#include <queue>
+#include <utility>
+#include <thread>
+#include <atomic>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef OBWODY_STATS
+#include <sys/resource.h>
+#endif
 
 namespace {
     using namespace std;
+    using namespace obwody;
 
-    // Definitions of Element related types and constants
-    inline namespace ElementTraits {
-        // Types
-        using ElementId = string;
-        using Description = string;
-        using Node = int;
-        using Nodes = vector<Node>;
-        using ElementNo = int;
-
-        enum class ElementType {
-            TRANSISTOR = 0,
-            DIODE,
-            RESISTOR,
-            CAPACITOR,
-            VOLTAGE_SOURCE,
-        };
+    inline namespace Output {
+        // Buffered writer of a file descriptor. Before anything is buffered, pending output of the paired
+        // writer is flushed, so lines of standard output and standard error keep their relative order.
+        class Writer {
+        public:
+            explicit Writer(int fd, Writer *paired = nullptr) : fd(fd), paired(paired) {
+                if (paired != nullptr) {
+                    paired->paired = this;
+                }
+            }
 
-        using Element = tuple<ElementType, ElementId, Description, Nodes>;
+            Writer(const Writer &) = delete;
 
-        // "Constants"
-        static const unordered_map<ElementType, size_t> nodesMapping {
-                {ElementType::TRANSISTOR,     3},
-                {ElementType::DIODE,          2},
-                {ElementType::RESISTOR,       2},
-                {ElementType::CAPACITOR,      2},
-                {ElementType::VOLTAGE_SOURCE, 2},
-        };
+            Writer &operator=(const Writer &) = delete;
 
-        static const unordered_map<ElementId::value_type, ElementType> typesMapping {
-                {'T', ElementType::TRANSISTOR},
-                {'D', ElementType::DIODE},
-                {'R', ElementType::RESISTOR},
-                {'C', ElementType::CAPACITOR},
-                {'E', ElementType::VOLTAGE_SOURCE},
-        };
+            ~Writer() {
+                flush();
+            }
+
+            Writer &operator<<(string_view text) {
+                reserve(text.size());
+                if (text.size() > buffer.size()) {
+                    writeAll(text.data(), text.size());
+                } else {
+                    used = copy(text.begin(), text.end(), buffer.begin() + used) - buffer.begin();
+                }
+                return *this;
+            }
+
+            Writer &operator<<(char c) {
+                reserve(1);
+                buffer[used++] = c;
+                return *this;
+            }
+
+            template<typename T, typename = enable_if_t<is_integral_v<T> && !is_same_v<T, char>>>
+            Writer &operator<<(T value) {
+                static constexpr size_t maxLength {numeric_limits<T>::digits10 + 2};
+                reserve(maxLength);
+                used = to_chars(buffer.data() + used, buffer.data() + buffer.size(), value).ptr - buffer.data();
+                return *this;
+            }
 
-        static const unordered_map<ElementType, ElementId::value_type> inverseTypesMapping {
-                {ElementType::TRANSISTOR,     'T'},
-                {ElementType::DIODE,          'D'},
-                {ElementType::RESISTOR,       'R'},
-                {ElementType::CAPACITOR,      'C'},
-                {ElementType::VOLTAGE_SOURCE, 'E'},
+            // Fixed notation, with three decimal places
+            Writer &operator<<(double value) {
+                static constexpr size_t maxLength {32};
+                static constexpr int precision {3};
+                reserve(maxLength);
+                char *end {buffer.data() + buffer.size()};
+                auto result = to_chars(buffer.data() + used, end, value, chars_format::fixed, precision);
+                if (result.ec == errc {}) {
+                    used = result.ptr - buffer.data();
+                }
+                return *this;
+            }
+
+            void flush() {
+                writeAll(buffer.data(), used);
+                used = 0;
+            }
+
+        private:
+            static constexpr size_t bufferSize {1 << 16};
+
+            int fd;
+            array<char, bufferSize> buffer;
+            size_t used {0};
+            Writer *paired;
+
+            // Make room for @size bytes, flushing whatever stands in the way
+            void reserve(size_t size) {
+                if (paired != nullptr && paired->used > 0) {
+                    paired->flush();
+                }
+                if (used + size > buffer.size()) {
+                    flush();
+                }
+            }
+
+            void writeAll(const char *data, size_t size) {
+                while (size > 0) {
+                    ssize_t written {::write(fd, data, size)};
+                    if (written < 0) {
+                        if (errno == EINTR) continue;
+                        return;
+                    }
+                    data += written;
+                    size -= written;
+                }
+            }
         };
-    }
 
-    // Basic Joins related types and constants
-    inline namespace JoinTraits {
-        using JoinId = int;
-        constexpr JoinId groundId {0};
-    }
+        // Writers of standard output and standard error, flushed at exit
+        Writer &out() {
+            static Writer writer {STDOUT_FILENO};
+            return writer;
+        }
 
-    inline namespace Output {
-        void error(const string &line, int lineNumber) {
-            cerr << "Error in line " << lineNumber << ": " << line << endl;
+        Writer &err() {
+            static Writer writer {STDERR_FILENO, &out()};
+            return writer;
         }
 
         // Print, separating values, with no separator after last element
-        template<typename C, typename P>
-        void printSeparating(const C &container, P &printer, const string &append = "") {
+        template<typename I, typename P>
+        void printSeparating(I begin, I end, P &printer, const string &append = "") {
             static const char *separator = ", ";
-            for (auto it = container.begin(); next(it) != container.end(); ++it) {
+            for (auto it = begin; next(it) != end; ++it) {
                 printer << append << *it << separator;
             }
-            printer << append << *container.rbegin();
+            printer << append << *prev(end);
+        }
+
+        void error(Writer &err, string_view line, int lineNumber) {
+            err << "Error in line " << lineNumber << ": " << line << '\n';
+        }
+
+        void showBillRow(Writer &out, ElementType type, const ElementNo *begin, const ElementNo *end,
+                         string_view description) {
+            printSeparating(begin, end, out, string(1, elementLetter(type)));
+            out << ": " << description << '\n';
+        }
+
+        void warnUnconnected(Writer &err, const vector<Node> &nodes) {
+            err << "Warning, unconnected node(s): ";
+            printSeparating(nodes.begin(), nodes.end(), err);
+            err << '\n';
+        }
+
+        void warnFloating(Writer &err, const Node *begin, const Node *end) {
+            err << "Warning, node(s) not connected to ground: ";
+            printSeparating(begin, end, err);
+            err << '\n';
+        }
+
+        // Writers of the bill and of errors and warnings, which may change between netlists
+        struct Printer {
+            Writer *out;
+            Writer *err;
+        };
+
+        // Analyzer printing everything it reports with @printer
+        NetlistAnalyzer printingAnalyzer(const Printer &printer, bool floating) {
+            NetlistAnalyzer analyzer {
+                    [&printer](string_view line, int lineNumber) {
+                        error(*printer.err, line, lineNumber);
+                    },
+                    [&printer](ElementType type, const ElementNo *begin, const ElementNo *end, string_view description) {
+                        showBillRow(*printer.out, type, begin, end, description);
+                    },
+                    [&printer](const vector<Node> &nodes) {
+                        warnUnconnected(*printer.err, nodes);
+                    }
+            };
+            if (floating) {
+                analyzer.setFloatingCallback([&printer](const Node *begin, const Node *end) {
+                    warnFloating(*printer.err, begin, end);
+                });
+            }
+            return analyzer;
         }
     }
 
-    inline namespace Parser {
-        Element parseEntry(const string &line, unordered_set<ElementId> &ids) {
-            // Regex used to parse lines
-            static std::string regexCommon = R"((?:0|[1-9][0-9]{0,8}))[\s]+([A-Z0-9][a-zA-Z0-9,\-\/]*)((?:[\s]+(?:0|[1-9][0-9]{0,8})))";
-            static std::string notTransistor = R"(^[\s]*([DRCE])" + regexCommon + R"({2})[\s]*$)";
-            static std::string transistor = R"(^[\s]*([T])" + regexCommon + R"({3})[\s]*$)";
-            static regex notTransistorRetrieve(notTransistor);
-            static regex transistorRetrieve(transistor);
+    inline namespace Input {
+        // Read-only memory mapping of a regular file, from its current offset to the end.
+        // Nothing is mapped for pipes, terminals and other files that cannot be mapped.
+        class MappedFile {
+        public:
+            explicit MappedFile(int fd) {
+                struct stat status {};
+                if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode) || status.st_size == 0) return;
+
+                off_t offset {lseek(fd, 0, SEEK_CUR)};
+                if (offset < 0 || offset >= status.st_size) return;
+
+                void *address {mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+                if (address == MAP_FAILED) return;
+                madvise(address, status.st_size, MADV_SEQUENTIAL);
+
+                mapping = string_view(static_cast<const char *>(address), status.st_size);
+                contents = mapping.substr(offset);
+            }
+
+            MappedFile(const MappedFile &) = delete;
+
+            MappedFile &operator=(const MappedFile &) = delete;
+
+            ~MappedFile() {
+                if (!mapping.empty()) {
+                    munmap(const_cast<char *>(mapping.data()), mapping.size());
+                }
+            }
+
+            bool mapped() const {
+                return !mapping.empty();
+            }
+
+            string_view data() const {
+                return contents;
+            }
+
+        private:
+            string_view mapping;
+            string_view contents;
+        };
+
+        // Descriptor of a file opened for reading (standard input if the path is empty), closed
+        // when it goes out of scope, also if analyzing the file throws
+        class InputFile {
+        public:
+            explicit InputFile(const string &path) : fd(path.empty() ? STDIN_FILENO : open(path.c_str(), O_RDONLY)) {
+                if (fd < 0) {
+                    throw system_error {errno, generic_category(), path};
+                }
+            }
+
+            InputFile(const InputFile &) = delete;
+
+            InputFile &operator=(const InputFile &) = delete;
+
+            ~InputFile() {
+                if (fd != STDIN_FILENO) close(fd);
+            }
+
+            int descriptor() const {
+                return fd;
+            }
+
+        private:
+            int fd;
+        };
+
+        void writeFile(const string &path, string_view contents) {
+            ofstream file {path, ios::binary};
+            if (!file.write(contents.data(), contents.size()).flush()) {
+                throw system_error {errno, generic_category(), path};
+            }
+        }
 
-            // Actual matching
-            smatch fields;
-            if (!regex_search(line, fields, transistorRetrieve) &&
-                !regex_search(line, fields, notTransistorRetrieve)) {
-                throw invalid_argument {""};
+        // Analyze file given by @path (standard input if empty), mapping it into memory if possible,
+        // or convert it to the binary form written to @compileTo, unless that is empty.
+        // Input that cannot be mapped is read line by line, unless it has to be read into memory first:
+        // to be split between more than one job, to be compiled, or if it is a binary netlist.
+        void analyze(const string &path, size_t jobs, const string &compileTo, NetlistAnalyzer &analyzer) {
+            InputFile file {path};
+            MappedFile input {file.descriptor()};
+            string_view netlist {input.data()};
+            string contents;
+            bool streamed {false};
+            if (!input.mapped()) {
+                ifstream unmapped;
+                if (!path.empty()) unmapped.open(path, ios::binary);
+                istream &stream {path.empty() ? cin : unmapped};
+
+                if (jobs > 1 || !compileTo.empty() || stream.peek() == compiledMagic[0]) {
+                    contents.assign(istreambuf_iterator<char> {stream}, istreambuf_iterator<char> {});
+                    netlist = contents;
+                } else {
+                    analyzer.analyze(stream);
+                    streamed = true;
+                }
             }
 
-            auto[id, type, desc] = tuple(fields[1], typesMapping.at(string {fields[1]}[0]), fields[2]);
+            if (streamed) {
+                // Already analyzed
+            } else if (!compileTo.empty()) {
+                writeFile(compileTo, analyzer.compile(netlist));
+            } else if (netlist.substr(0, compiledMagic.size()) == compiledMagic) {
+                analyzer.analyzeCompiled(netlist);
+            } else {
+                analyzer.analyze(netlist);
+            }
+        }
+    }
 
-            // Check for repetitive ids
-            if (ids.find(id) != ids.end()) {
-                throw invalid_argument {""};
+    inline namespace Follow {
+        // File growing at its end, read in whole lines
+        class GrowingFile {
+        public:
+            explicit GrowingFile(const string &path) : fd(open(path.c_str(), O_RDONLY)) {
+                if (fd < 0) {
+                    throw system_error {errno, generic_category(), path};
+                }
             }
 
-            // Extract node values and check for not being the same
-            stringstream ss(fields[3]);
-            Nodes nodes(nodesMapping.at(type));
-            copy(istream_iterator<Node> {ss}, istream_iterator<Node> {}, nodes.begin());
+            GrowingFile(const GrowingFile &) = delete;
+
+            GrowingFile &operator=(const GrowingFile &) = delete;
 
-            if (set(nodes.begin(), nodes.end()).size() <= 1) {
-                throw invalid_argument {""};
+            ~GrowingFile() {
+                close(fd);
             }
 
-            ids.insert(id);
-            return {type, id, desc, nodes};
+            // Add lines appended since the previous call to @analyzer, keeping an unfinished last line for later.
+            // A file that got shorter has been rewritten, so it is analyzed again from its beginning.
+            void addAppended(NetlistAnalyzer &analyzer) {
+                struct stat status {};
+                if (fstat(fd, &status) != 0) {
+                    throw system_error {errno, generic_category()};
+                }
+                if (status.st_size < offset) {
+                    analyzer.reset();
+                    pending.clear();
+                    offset = 0;
+                }
+
+                array<char, 1 << 16> buffer;
+                for (ssize_t count; (count = pread(fd, buffer.data(), buffer.size(), offset)) != 0; offset += count) {
+                    if (count < 0) {
+                        if (errno == EINTR) continue;
+                        throw system_error {errno, generic_category()};
+                    }
+                    pending.append(buffer.data(), count);
+                }
+
+                size_t end {pending.rfind('\n')};
+                if (end != string::npos) {
+                    analyzer.addLines(string_view {pending}.substr(0, end + 1));
+                    pending.erase(0, end + 1);
+                }
+            }
+
+        private:
+            int fd;
+            off_t offset {0};
+            string pending;
+        };
+
+        // Report the file given by @path, then again after every line of standard input, reading only what
+        // has been appended to the file in the meantime. Reports are the same as those of separate runs,
+        // except that errors are printed once, as soon as their lines are read.
+        void follow(const string &path, NetlistAnalyzer &analyzer) {
+            analyzer.reset();
+            analyzer.setIncremental(true);
+            GrowingFile file {path};
+            string request;
+            do {
+                file.addAppended(analyzer);
+                analyzer.report();
+                out().flush();
+                err().flush();
+            } while (getline(cin, request));
         }
+    }
 
-        vector<Element> read() {
-            vector<Element> result;
-            string line;
-            unordered_set<ElementId> ids;
+    inline namespace Batch {
+        // File created (or truncated) for writing
+        class OutputFile {
+        public:
+            explicit OutputFile(const string &path) : fd(open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666)) {
+                if (fd < 0) {
+                    throw system_error {errno, generic_category(), path};
+                }
+            }
+
+            OutputFile(const OutputFile &) = delete;
+
+            OutputFile &operator=(const OutputFile &) = delete;
+
+            ~OutputFile() {
+                close(fd);
+            }
 
-            // Parse input line by line
-            for (int lineNumber {1}; getline(cin, line); ++lineNumber) {
-                if (line.empty()) continue;
+            int descriptor() const {
+                return fd;
+            }
 
-                // Log in case of error
+        private:
+            int fd;
+        };
+
+        // Analyze file given by @path, writing what a separate run would print to its standard output
+        // and standard error to files named @path with .out and .err appended. Returns false on errors.
+        bool analyzeToFiles(const string &path, Printer &printer, NetlistAnalyzer &analyzer, mutex &errors) {
+            try {
+                OutputFile outFile {path + ".out"}, errFile {path + ".err"};
+                Writer out {outFile.descriptor()}, err {errFile.descriptor(), &out};
+                printer = {&out, &err};
                 try {
-                    result.push_back(parseEntry(line, ids));
-                } catch (invalid_argument &) {
-                    error(line, lineNumber);
+                    Input::analyze(path, 1, "", analyzer);
+                    return true;
+                } catch (system_error &e) {
+                    err << e.what() << '\n';
+                } catch (invalid_argument &e) {
+                    err << e.what() << '\n';
                 }
+            } catch (system_error &e) {
+                lock_guard<mutex> lock {errors};
+                err() << e.what() << '\n';
             }
+            return false;
+        }
 
-            return result;
+        // Analyze files given by @paths on a pool of @jobs threads (0 meaning one per core), each of them
+        // reusing one analyzer for all its files. Returns false if any file could not be analyzed.
+        bool analyzeBatch(const vector<string> &paths, size_t jobs, bool floating) {
+            atomic<size_t> next {0};
+            atomic<bool> failed {false};
+            mutex errors;
+
+            auto work = [&]() {
+                Printer printer {nullptr, nullptr};
+                NetlistAnalyzer analyzer {printingAnalyzer(printer, floating)};
+                for (size_t i; (i = next++) < paths.size();) {
+                    if (!analyzeToFiles(paths[i], printer, analyzer, errors)) {
+                        failed = true;
+                    }
+                }
+            };
+
+            size_t workersCount {jobs == 0 ? max(1u, thread::hardware_concurrency()) : jobs};
+            vector<thread> workers;
+            for (size_t i {1}; i < min(workersCount, paths.size()); ++i) {
+                workers.emplace_back(work);
+            }
+            work();
+            for (thread &worker : workers) {
+                worker.join();
+            }
+            return !failed;
         }
     }
 
-    inline namespace Result {
-        auto calculateJoinsAndBill(const vector<Element> &elements) {
-            map<JoinId, int> joins;
-            map<ElementType, map<Description, set<ElementNo>>> bill;
+    inline namespace Diff {
+        // Designator (type and number) of an element with its description
+        using Designated = tuple<ElementType, ElementNo, string_view>;
+
+        // Correct elements of a netlist ordered by designators, built from its bill of materials.
+        // Rejected lines and unconnected nodes are ignored, it is the bill that is compared.
+        class DesignatorList {
+        public:
+            DesignatorList(const string &path, size_t jobs) : analyzer {
+                    [](string_view, int) {},
+                    [this](ElementType type, const ElementNo *begin, const ElementNo *end, string_view description) {
+                        rows.emplace_back(elements.size(), elements.size() + (end - begin));
+                        for (const ElementNo *number = begin; number != end; ++number) {
+                            elements.emplace_back(type, *number, description);
+                        }
+                    },
+                    [](const vector<Node> &) {}
+            } {
+                analyzer.setJobs(jobs);
+                Input::analyze(path, jobs, "", analyzer);
+                mergeRows();
+            }
+
+            DesignatorList(const DesignatorList &) = delete;
+
+            DesignatorList &operator=(const DesignatorList &) = delete;
+
+            const vector<Designated> &designated() const {
+                return elements;
+            }
 
-            // Create histogram of used joins
-            // And group ids by type and description
-            joins[groundId] = 0;
-            for (const Element &element : elements) {
-                const auto&[type, id, description, nodes] = element;
-                set<Node> nodesUnique(nodes.begin(), nodes.end());
-                for_each(nodesUnique.begin(), nodesUnique.end(), [&](Node node) { ++joins[node]; });
-                bill[type][description].insert(stoi(id.substr(1, id.length() - 1)));
+        private:
+            // Descriptions point into the pool of the analyzer
+            vector<Designated> elements;
+            // Rows of the bill as ranges of elements
+            vector<pair<size_t, size_t>> rows;
+            NetlistAnalyzer analyzer;
+
+            // Rows come ordered by type and first number, each with ascending numbers, but numbers of rows
+            // of the same type interleave. Merge them taking the smallest first element from a heap, which
+            // a row joins only once its first element may come next, so it holds overlapping rows only.
+            void mergeRows() {
+                auto later = [this](const pair<size_t, size_t> &a, const pair<size_t, size_t> &b) {
+                    return elements[b.first] < elements[a.first];
+                };
+                priority_queue<pair<size_t, size_t>, vector<pair<size_t, size_t>>, decltype(later)> heap {later};
+                vector<Designated> merged;
+                merged.reserve(elements.size());
+                for (size_t next {0}; next < rows.size() || !heap.empty();) {
+                    if (next < rows.size() && (heap.empty() || !later(rows[next], heap.top()))) {
+                        heap.push(rows[next++]);
+                        continue;
+                    }
+                    auto [begin, end] {heap.top()};
+                    heap.pop();
+                    merged.push_back(elements[begin]);
+                    if (++begin != end) heap.emplace(begin, end);
+                }
+                elements.swap(merged);
+                rows.clear();
             }
+        };
 
-            return make_pair(joins, bill);
+        // Element added (+) or removed (-), or moved (~) from the description @previous
+        void showChange(char change, const Designated &element, string_view previous = {}) {
+            const auto &[type, number, description] = element;
+            out() << change << ' ' << elementLetter(type) << number << ": ";
+            if (!previous.empty()) {
+                out() << previous << " -> ";
+            }
+            out() << description << '\n';
         }
 
-        void showBilling(const map<ElementType, map<Description, set<ElementNo>>> &bill) {
-            // Iterate over element types
-            for (const auto &billing : bill) {
-                // Calculate inverse of map descriptions -> ids
-                map<set<ElementNo>, Description> inverse;
-                for (const auto &row : billing.second) {
-                    inverse[row.second] = row.first;
+        // Print elements of @after missing from @before (+), those of @before missing from @after (-)
+        // and those moved to another description (~), merging both lists in a single pass
+        void showDiff(const vector<Designated> &before, const vector<Designated> &after) {
+            auto designator = [](const Designated &element) {
+                return make_pair(get<ElementType>(element), get<ElementNo>(element));
+            };
+
+            auto old = before.begin(), current = after.begin();
+            while (old != before.end() || current != after.end()) {
+                if (current == after.end() || (old != before.end() && designator(*old) < designator(*current))) {
+                    showChange('-', *old++);
+                } else if (old == before.end() || designator(*current) < designator(*old)) {
+                    showChange('+', *current++);
+                } else {
+                    if (get<string_view>(*old) != get<string_view>(*current)) {
+                        showChange('~', *current, get<string_view>(*old));
+                    }
+                    ++old;
+                    ++current;
                 }
+            }
+        }
+    }
+
+    inline namespace CommandLine {
+        struct Options {
+            // Parsing threads, 0 meaning as many as there are cores
+            size_t jobs {1};
+            // Input file, standard input if empty
+            string path;
+            // File the net index of input is written to, none if empty
+            string indexTo;
+            // Look up nodes or an element in the net index given as the file, instead of analyzing it
+            string query;
+            // Netlist the input is compared with, instead of analyzing it, none if empty
+            string diffFrom;
+            // Analyze every file of paths, to files of their own, paths read from standard input if none given
+            bool batch {false};
+            vector<string> paths;
+            // Descriptor statistics are written to, none if negative
+            int statsFd {-1};
+            // File the binary form of input is written to instead of analyzing it, none if empty
+            string compileTo;
+            // Report the file again on every line of standard input
+            bool follow {false};
+            // Report groups of nodes not connected to ground
+            bool floating {false};
+        };
+
+        constexpr const char *usage {
+#ifdef OBWODY_STATS
+                " [-j jobs] [--compile binary | --follow | --batch | --diff old | --query nodes] [--floating]"
+                " [--index index] [--stats[=fd]] [file...]\n"
+#else
+                " [-j jobs] [--compile binary | --follow | --batch | --diff old | --query nodes] [--floating]"
+                " [--index index] [file...]\n"
+#endif
+        };
 
-                // Show sorted result
-                for (const auto &row : inverse) {
-                    printSeparating(row.first, cout, string(1, inverseTypesMapping.at(billing.first)));
-                    cout << ": " << row.second << endl;
+        // Whole @value has to be a number
+        template<typename T>
+        bool parseNumber(string_view value, T &result) {
+            auto[end, status] = from_chars(value.data(), value.data() + value.size(), result);
+            return status == errc {} && end == value.data() + value.size();
+        }
+
+        bool parseOptions(int argc, char *argv[], Options &options) {
+            for (int i {1}; i < argc; ++i) {
+                string_view arg {argv[i]};
+                if (arg == "-j" && i + 1 < argc) {
+                    if (!parseNumber(argv[++i], options.jobs)) return false;
+                } else if (arg == "--compile" && i + 1 < argc) {
+                    options.compileTo = argv[++i];
+                } else if (arg == "--follow") {
+                    options.follow = true;
+                } else if (arg == "--index" && i + 1 < argc) {
+                    options.indexTo = argv[++i];
+                } else if (arg == "--query" && i + 1 < argc) {
+                    options.query = argv[++i];
+                } else if (arg == "--diff" && i + 1 < argc) {
+                    options.diffFrom = argv[++i];
+                } else if (arg == "--batch") {
+                    options.batch = true;
+                } else if (arg == "--floating") {
+                    options.floating = true;
+#ifdef OBWODY_STATS
+                } else if (arg == "--stats") {
+                    options.statsFd = 3;
+                } else if (arg.substr(0, 8) == "--stats=") {
+                    if (!parseNumber(arg.substr(8), options.statsFd)) return false;
+#endif
+                } else if (!arg.empty() && arg[0] != '-') {
+                    options.paths.emplace_back(arg);
+                } else {
+                    return false;
                 }
             }
+
+            // Files of a batch and compared ones are only analyzed, with no statistics and no index,
+            // indexes are only queried
+            bool plain {options.compileTo.empty() && !options.follow && options.statsFd < 0 &&
+                        options.indexTo.empty()};
+            if (options.batch) {
+                return plain && options.diffFrom.empty() && options.query.empty();
+            }
+            if (!options.diffFrom.empty() && (!plain || !options.query.empty())) return false;
+            if (!options.query.empty() && (!plain || options.paths.size() != 1)) return false;
+            if (!options.indexTo.empty() && (!options.compileTo.empty() || options.follow)) return false;
+            if (options.paths.size() > 1) return false;
+            if (!options.paths.empty()) options.path = options.paths.front();
+            // Only a file can be followed, and it is analyzed, not compiled
+            return !options.follow || (!options.path.empty() && options.compileTo.empty());
         }
+    }
 
-        void checkForUnconnected(const map<JoinId, int> &joins) {
-            // Fetch all unconnected
-            set<int> unconnected;
-            for (const auto &join : joins) {
-                if (join.second < 2) {
-                    unconnected.insert(join.first);
+    inline namespace Query {
+        // Element of type given by its letter @letter, false if there is no such type
+        bool parseType(char letter, ElementType &type) {
+            for (ElementType candidate : {ElementType::TRANSISTOR, ElementType::DIODE, ElementType::RESISTOR,
+                                          ElementType::CAPACITOR, ElementType::VOLTAGE_SOURCE}) {
+                if (elementLetter(candidate) == letter) {
+                    type = candidate;
+                    return true;
                 }
             }
+            return false;
+        }
 
-            // Show warning if there are some
-            if (!unconnected.empty()) {
-                cerr << "Warning, unconnected node(s): ";
-                printSeparating(unconnected, cerr);
-                cerr << endl;
+        // Print elements connected to nodes given by @spec ("node" or "first-last"), or nodes of the element
+        // it designates, looking them up in the net index saved in @path. Returns false if @spec is incorrect.
+        bool query(const string &path, string_view spec) {
+            int fd {open(path.c_str(), O_RDONLY)};
+            if (fd < 0) {
+                throw system_error {errno, generic_category(), path};
+            }
+            MappedFile mapped {fd};
+            string contents;
+            if (!mapped.mapped()) {
+                ifstream file {path, ios::binary};
+                contents.assign(istreambuf_iterator<char> {file}, istreambuf_iterator<char> {});
+            }
+            close(fd);
+            NetIndex index {mapped.mapped() ? mapped.data() : string_view {contents}};
+
+            ElementType type;
+            ElementNo number;
+            Node first, last;
+            size_t dash {spec.find('-')};
+            if (!spec.empty() && parseType(spec[0], type) && parseNumber(spec.substr(1), number)) {
+                vector<Node> nodes {index.elementNodes({type, number})};
+                if (!nodes.empty()) {
+                    out() << spec << ": ";
+                    printSeparating(nodes.begin(), nodes.end(), out());
+                    out() << '\n';
+                }
+            } else if (parseNumber(spec.substr(0, dash), first) &&
+                       (dash == string_view::npos ? (last = first, true) : parseNumber(spec.substr(dash + 1), last))) {
+                index.nodes(first, last, [](Node node, const vector<Designator> &elements) {
+                    out() << node << ": ";
+                    for (size_t i {0}; i < elements.size(); ++i) {
+                        out() << (i == 0 ? "" : ", ") << elementLetter(elements[i].first) << elements[i].second;
+                    }
+                    out() << '\n';
+                });
+            } else {
+                return false;
             }
+            return true;
         }
     }
+
+#ifdef OBWODY_STATS
+    inline namespace Stats {
+        void showStatistics(const Statistics &statistics, int fd) {
+            rusage usage {};
+            getrusage(RUSAGE_SELF, &usage);
+            double linesPerSecond {statistics.readSeconds > 0 ? statistics.lines / statistics.readSeconds : 0};
+
+            Writer writer {fd};
+            writer << "read: " << statistics.readSeconds << " s\n"
+                   << "joins and bill: " << statistics.joinsAndBillSeconds << " s\n"
+                   << "billing: " << statistics.billingSeconds << " s\n"
+                   << "unconnected: " << statistics.unconnectedSeconds << " s\n"
+                   << "floating: " << statistics.floatingSeconds << " s\n"
+                   << "index: " << statistics.indexSeconds << " s\n"
+                   << "lines: " << statistics.lines << '\n'
+                   << "lines per second: " << linesPerSecond << '\n'
+                   << "rejected, syntax: " << statistics.syntaxErrors << '\n'
+                   << "rejected, repeated designator: " << statistics.repeatedDesignators << '\n'
+                   << "rejected, all nodes the same: " << statistics.shortedElements << '\n'
+                   << "distinct descriptions: " << statistics.descriptions << '\n'
+                   << "distinct nodes: " << statistics.nodes << '\n'
+                   << "groups not connected to ground: " << statistics.floatingGroups << '\n'
+                   << "peak memory: " << usage.ru_maxrss << " KiB\n";
+        }
+    }
+#endif
 }
 
-int main() {
-    // Parse input
-    auto elements = read();
+int main(int argc, char *argv[]) {
+    ios_base::sync_with_stdio(false);
+
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        err() << "Usage: " << argv[0] << usage;
+        return 1;
+    }
 
-    // Calculate intermediate results
-    auto[joins, bill] = calculateJoinsAndBill(elements);
+    if (options.batch) {
+        if (options.paths.empty()) {
+            for (string path; getline(cin, path);) {
+                if (!path.empty()) options.paths.push_back(path);
+            }
+        }
+        return analyzeBatch(options.paths, options.jobs, options.floating) ? 0 : 1;
+    }
 
-    // Output in appropriate way
-    showBilling(bill);
-    checkForUnconnected(joins);
+    if (!options.query.empty()) {
+        try {
+            if (query(options.path, options.query)) return 0;
+            err() << "Usage: " << argv[0] << usage;
+        } catch (system_error &e) {
+            err() << e.what() << '\n';
+        } catch (invalid_argument &e) {
+            err() << e.what() << '\n';
+        }
+        return 1;
+    }
+
+    if (!options.diffFrom.empty()) {
+        try {
+            DesignatorList before {options.diffFrom, options.jobs}, after {options.path, options.jobs};
+            showDiff(before.designated(), after.designated());
+            return 0;
+        } catch (system_error &e) {
+            err() << e.what() << '\n';
+        } catch (invalid_argument &e) {
+            err() << e.what() << '\n';
+        }
+        return 1;
+    }
+
+    Printer printer {&out(), &err()};
+    NetlistAnalyzer analyzer {printingAnalyzer(printer, options.floating)};
+    analyzer.setJobs(options.jobs);
+    analyzer.setIndexing(!options.indexTo.empty());
+
+    // Analyze (compile or follow) input, standard input unless a file is given
+    try {
+        if (options.follow) {
+            follow(options.path, analyzer);
+        } else {
+            Input::analyze(options.path, options.jobs, options.compileTo, analyzer);
+            if (!options.indexTo.empty()) {
+                writeFile(options.indexTo, analyzer.index());
+            }
+        }
+    } catch (system_error &e) {
+        err() << e.what() << '\n';
+        return 1;
+    } catch (invalid_argument &e) {
+        err() << e.what() << '\n';
+        return 1;
+    }
+
+#ifdef OBWODY_STATS
+    if (options.statsFd >= 0) {
+        showStatistics(analyzer.statistics(), options.statsFd);
+    }
+#endif
 }
@@ -0,0 +1,157 @@
+#ifndef OBWODY_SCAN_H
+#define OBWODY_SCAN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define OBWODY_SCAN_X86
+#endif
+
+// Vectorized pre-pass over blocks of netlists. Bytes are classified 64 at a time (with AVX2 or SSE2,
+// whichever the processor supports, or without SIMD), and positions of line ends and token boundaries
+// are listed, so that lines can be split into tokens without looking at their bytes one by one.
+namespace obwody::scan {
+
+    // Positions within a block: of newlines, and of token boundaries, that is of bytes of other class
+    // (whitespace or not) than the previous byte, whitespace being assumed before the block.
+    // Token boundaries alternate between beginnings and ends of tokens.
+    // Only the first @lineEndCount and @boundaryCount positions belong to the block: vectors are grown
+    // as needed, never shrunk, so that a reused index is not zeroed again for every block.
+    struct BlockIndex {
+        std::vector<uint32_t> lineEnds;
+        size_t lineEndCount {0};
+        std::vector<uint32_t> boundaries;
+        size_t boundaryCount {0};
+    };
+
+    // Newlines and whitespace (space, \t, \n, \v, \f and \r) of 64 bytes, as bitmasks
+    struct WordMasks {
+        uint64_t newlines;
+        uint64_t spaces;
+    };
+
+    inline WordMasks classifyScalar(const char *data) {
+        WordMasks masks {0, 0};
+        for (int i = 0; i < 64; ++i) {
+            auto c = static_cast<unsigned char>(data[i]);
+            masks.newlines |= uint64_t {c == '\n'} << i;
+            masks.spaces |= uint64_t {c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t'} << i;
+        }
+        return masks;
+    }
+
+#ifdef OBWODY_SCAN_X86
+    __attribute__((target("sse2")))
+    inline WordMasks classifySse2(const char *data) {
+        WordMasks masks {0, 0};
+        for (int i = 0; i < 64; i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            // \t to \r, as unsigned bytes below 5 after subtracting \t
+            __m128i shifted = _mm_sub_epi8(bytes, _mm_set1_epi8('\t'));
+            __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+            __m128i spaces = _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(' ')), control);
+            __m128i newlines = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\n'));
+            masks.newlines |= uint64_t {static_cast<uint16_t>(_mm_movemask_epi8(newlines))} << i;
+            masks.spaces |= uint64_t {static_cast<uint16_t>(_mm_movemask_epi8(spaces))} << i;
+        }
+        return masks;
+    }
+
+    __attribute__((target("avx2")))
+    inline WordMasks classifyAvx2(const char *data) {
+        WordMasks masks {0, 0};
+        for (int i = 0; i < 64; i += 32) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            __m256i shifted = _mm256_sub_epi8(bytes, _mm256_set1_epi8('\t'));
+            __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8('\r' - '\t')), shifted);
+            __m256i spaces = _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' ')), control);
+            __m256i newlines = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\n'));
+            masks.newlines |= uint64_t {static_cast<uint32_t>(_mm256_movemask_epi8(newlines))} << i;
+            masks.spaces |= uint64_t {static_cast<uint32_t>(_mm256_movemask_epi8(spaces))} << i;
+        }
+        return masks;
+    }
+#endif
+
+    // Append positions of set bits of @bits, counted from @base, at @out
+    inline uint32_t *flatten(uint64_t bits, uint32_t base, uint32_t *out) {
+        for (; bits != 0; bits &= bits - 1) {
+            *out++ = base + static_cast<uint32_t>(__builtin_ctzll(bits));
+        }
+        return out;
+    }
+
+    // Index @block with @classify, the last partial word copied into a buffer padded with spaces
+    template<typename Classify>
+    inline void indexWith(std::string_view block, BlockIndex &index, Classify classify) {
+        // One more line end than there are bytes, which a block not ending with newline may need
+        if (index.lineEnds.size() < block.size() + 1) index.lineEnds.resize(block.size() + 1);
+        if (index.boundaries.size() < block.size() + 64) index.boundaries.resize(block.size() + 64);
+        uint32_t *lineEnds {index.lineEnds.data()};
+        uint32_t *boundaries {index.boundaries.data()};
+
+        uint64_t previousSpace {1};
+        auto indexWord = [&](WordMasks masks, uint32_t base) {
+            uint64_t changes {masks.spaces ^ (masks.spaces << 1 | previousSpace)};
+            previousSpace = masks.spaces >> 63;
+            lineEnds = flatten(masks.newlines, base, lineEnds);
+            boundaries = flatten(changes, base, boundaries);
+        };
+
+        size_t position {0};
+        for (; position + 64 <= block.size(); position += 64) {
+            indexWord(classify(block.data() + position), position);
+        }
+        if (position < block.size()) {
+            char last[64];
+            std::memset(last, ' ', sizeof(last));
+            std::memcpy(last, block.data() + position, block.size() - position);
+            indexWord(classify(last), position);
+        }
+
+        index.lineEndCount = lineEnds - index.lineEnds.data();
+        // Boundaries of the padding are not a part of the block
+        while (boundaries != index.boundaries.data() && boundaries[-1] >= block.size()) --boundaries;
+        index.boundaryCount = boundaries - index.boundaries.data();
+    }
+
+    inline void indexBlockScalar(std::string_view block, BlockIndex &index) {
+        indexWith(block, index, classifyScalar);
+    }
+
+#ifdef OBWODY_SCAN_X86
+    __attribute__((target("sse2")))
+    inline void indexBlockSse2(std::string_view block, BlockIndex &index) {
+        indexWith(block, index, [](const char *data) __attribute__((target("sse2"))) { return classifySse2(data); });
+    }
+
+    __attribute__((target("avx2")))
+    inline void indexBlockAvx2(std::string_view block, BlockIndex &index) {
+        indexWith(block, index, [](const char *data) __attribute__((target("avx2"))) { return classifyAvx2(data); });
+    }
+#endif
+
+    using IndexBlock = void (*)(std::string_view block, BlockIndex &index);
+
+    // The fastest implementation the processor supports, with its name
+    inline std::pair<IndexBlock, const char *> bestImplementation() {
+#ifdef OBWODY_SCAN_X86
+        if (__builtin_cpu_supports("avx2")) return {indexBlockAvx2, "avx2"};
+        if (__builtin_cpu_supports("sse2")) return {indexBlockSse2, "sse2"};
+#endif
+        return {indexBlockScalar, "scalar"};
+    }
+
+    // Index @block (at most 4 GiB) with the fastest implementation, chosen once
+    inline void indexBlock(std::string_view block, BlockIndex &index) {
+        static const IndexBlock implementation {bestImplementation().first};
+        implementation(block, index);
+    }
+}
+
+#endif //OBWODY_SCAN_H
@@ -0,0 +1,112 @@
+#!/bin/bash
+
+# Runs obwody on every tests/_schemat_*.in and compares its output with the expected one.
+# The reference regex parser (-DOBWODY_REGEX_PARSER) is tested as well and both builds
+# have to give byte for byte identical output on randomly generated netlists, so does
+# the parallel parser. Binary netlists made with --compile have to give the same output
+# as the text they were made from. Groups of nodes not connected to ground (--floating)
+# are checked on tests/_floating_*.in, differences of bills (--diff) of tests/_diff_*.old
+# and tests/_diff_*.in on tests/_diff_*.out, and answers to tests/_index_*.queries from net
+# indexes (--index, --query) of tests/_index_*.in on tests/_index_*.out.
+
+CXX="g++ -Wall -Wextra -O2 -std=c++17 -pthread"
+
+$CXX obwody.cc netlist.cc -o out || exit 1
+$CXX -DOBWODY_REGEX_PARSER obwody.cc netlist.cc -o out_regex || exit 1
+$CXX -DOBWODY_STATS obwody.cc netlist.cc -o out_stats || exit 1
+
+result=0
+
+check() {
+  echo -ne "$1\t"
+  if $2
+  then
+    echo -e "\033[0;32mpassed\033[0m"
+  else
+    echo -e "\033[0;31mfailed\033[0m"
+    result=1
+  fi
+}
+
+for f in tests/_schemat_*.in
+do
+  for b in out out_regex
+  do
+    check "$f ($b)" "eval ./$b < $f > out.out 2> out.err && cmp -s out.out ${f%.in}.out && cmp -s out.err ${f%.in}.err"
+  done
+  check "$f (pipe)" "eval cat $f | ./out > out.out 2> out.err && cmp -s out.out ${f%.in}.out && cmp -s out.err ${f%.in}.err"
+  check "$f (file)" "eval ./out $f > out.out 2> out.err && cmp -s out.out ${f%.in}.out && cmp -s out.err ${f%.in}.err"
+  check "$f (2>&1)" "eval ./out < $f > out.out 2>&1 && cat <(grep -v '^Warning' ${f%.in}.err) ${f%.in}.out <(grep '^Warning' ${f%.in}.err) | cmp -s - out.out"
+  check "$f (--stats)" "eval ./out_stats --stats < $f > out.out 2> out.err 3> /dev/null && cmp -s out.out ${f%.in}.out && cmp -s out.err ${f%.in}.err"
+  check "$f (-j 4)" "eval ./out -j 4 < $f > out.out 2> out.err && cmp -s out.out ${f%.in}.out && cmp -s out.err ${f%.in}.err"
+  # Followed files are reported twice, an unfinished last line waits for its newline
+  while IFS= read -r line; do echo "$line"; done < $f > follow.in
+  ./out < follow.in > follow.out 2> follow.err
+  check "$f (--follow)" "eval printf '\\n' | ./out --follow $f > out.out 2> out.err && cat follow.out follow.out | cmp -s - out.out && cat follow.err <(grep '^Warning' follow.err) | cmp -s - out.err"
+  check "$f (--floating)" "eval ./out --floating $f > out.out 2> out.err && cmp -s out.out ${f%.in}.out && grep -v 'not connected to ground' out.err | cmp -s - ${f%.in}.err"
+  check "$f (--diff itself)" "eval ./out --diff $f $f > out.out && [ ! -s out.out ]"
+  check "$f (--index)" "eval ./out --index out.idx $f > out.out 2> out.err && cmp -s out.out ${f%.in}.out && cmp -s out.err ${f%.in}.err"
+  check "$f (binary)" "eval ./out --compile out.bin $f && ./out out.bin > out.out 2> out.err && cmp -s out.out ${f%.in}.out && cmp -s out.err ${f%.in}.err"
+  check "$f (binary pipe)" "eval cat out.bin | ./out > out.out 2> out.err && cmp -s out.out ${f%.in}.out && cmp -s out.err ${f%.in}.err"
+done
+
+for f in tests/_floating_*.in
+do
+  check "$f" "eval ./out --floating < $f > out.out 2> out.err && cmp -s out.out ${f%.in}.out && cmp -s out.err ${f%.in}.err"
+  check "$f (--follow)" "eval ./out --floating --follow $f < /dev/null > out.out 2> out.err && cmp -s out.out ${f%.in}.out && cmp -s out.err ${f%.in}.err"
+done
+
+for f in tests/_diff_*.in
+do
+  check "$f" "eval ./out --diff ${f%.in}.old < $f > out.out && cmp -s out.out ${f%.in}.out"
+done
+
+for f in tests/_index_*.in
+do
+  ./out --index out.idx $f > /dev/null 2>&1
+  check "$f" "eval while read q; do ./out --query \$q out.idx; done < ${f%.in}.queries > out.out && cmp -s out.out ${f%.in}.out"
+done
+
+for seed in 1 2 3 4 5
+do
+  awk -v seed=$seed -v lines=20000 -f tests/fuzz.awk > fuzz.in
+  ./out < fuzz.in > out.out 2> out.err
+  ./out_regex < fuzz.in > out_regex.out 2> out_regex.err
+  check "fuzz $seed" "eval cmp -s out.out out_regex.out && cmp -s out.err out_regex.err"
+  ./out -j 4 < fuzz.in > out_regex.out 2> out_regex.err
+  check "fuzz $seed (-j 4)" "eval cmp -s out.out out_regex.out && cmp -s out.err out_regex.err"
+  ./out --compile out.bin fuzz.in && ./out out.bin > out_regex.out 2> out_regex.err
+  check "fuzz $seed (binary)" "eval cmp -s out.out out_regex.out && cmp -s out.err out_regex.err"
+done
+
+# Batch output of every file has to be the same as that of a separate run with options $1
+batch_matches() {
+  for f in batch/*.in
+  do
+    ./out $1 < $f > out.out 2> out.err
+    cmp -s out.out $f.out && cmp -s out.err $f.err || return 1
+  done
+}
+
+rm -rf batch && mkdir batch && cp tests/_schemat_*.in tests/_floating_*.in batch/
+./out -j 3 --batch batch/*.in
+check "--batch" "batch_matches"
+(ls batch/*.in; echo batch/missing.in) | ./out -j 0 --batch --floating
+status=$?
+check "--batch (paths on standard input)" "eval [ $status -ne 0 ] && grep -q 'No such file' batch/missing.in.err && batch_matches --floating"
+rm -rf batch
+
+# Files rejected in batch mode are closed, so more of them than descriptors allowed do not affect later ones
+rm -rf batch && mkdir batch
+./out --compile out.bin tests/_schemat_1.in
+for i in $(seq 10 49); do head -c 20 out.bin > batch/bad_$i.in; done
+cp tests/_schemat_1.in batch/good.in
+(ulimit -n 20 && ./out --batch batch/bad_*.in batch/good.in)
+check "--batch (rejected files closed)" "eval grep -q . batch/bad_49.in.err && cmp -s batch/good.in.out tests/_schemat_1.out && cmp -s batch/good.in.err tests/_schemat_1.err"
+rm -rf batch
+
+$CXX tests/netlist_test.cc netlist.cc -o out_test || exit 1
+check "tests/netlist_test.cc" "./out_test $(ls tests/_schemat_*.in | sed 's/\.in$//' | tr '\n' ' ')"
+
+rm -f out out_regex out_stats out_test out.bin out.idx follow.in follow.out follow.err out.out out.err out_regex.out out_regex.err fuzz.in
+exit $result
@@ -0,0 +1,49 @@
+# Generates random, mostly almost correct netlist lines, used for differential testing.
+# Usage: awk -v seed=1 -v lines=10000 -f fuzz.awk
+
+function pick(list,    n, items) {
+    n = split(list, items, "|")
+    return items[int(rand() * n) + 1]
+}
+
+function space() {
+    if (rand() < 0.9) return "_"
+    return pick("__|\t|_\t|\v|\f|\r|___")
+}
+
+function number() {
+    if (rand() < 0.95) return int(rand() * 40)
+    return pick("0|00|01|007|9|10|99|999999999|1000000000|123456789|0123456789|-1|+1|1a|1.5")
+}
+
+function designator() {
+    if (rand() < 0.95) return pick("T|D|R|C|E") int(rand() * lines)
+    return pick("X|t|r|RR|T|R") (rand() < 0.5 ? "" : number())
+}
+
+function description() {
+    if (rand() < 0.95) return pick("BC107|1N4148|1k/0,125W|47k|2N2222A|1uF/6,3V|5V|0|Z-9|Ab/,-")
+    return pick("a1k|_1k|k|1k.5|1k_5|1kΩ|10µF|,x")
+}
+
+function line(    s, i, nodes) {
+    if (rand() < 0.03) return ""
+    if (rand() < 0.02) return space()
+
+    s = designator()
+    nodes = (rand() < 0.9 ? (s ~ /^T/ ? 3 : 2) : pick("1|2|3|4"))
+    s = (rand() < 0.3 ? space() : "") s space() description()
+    for (i = 0; i < nodes; ++i) s = s space() number()
+    if (rand() < 0.3) s = s space()
+    if (rand() < 0.02) s = s "#"
+    return s
+}
+
+BEGIN {
+    srand(seed)
+    for (n = 0; n < lines; ++n) {
+        l = line()
+        gsub(/_/, " ", l)
+        print l
+    }
+}
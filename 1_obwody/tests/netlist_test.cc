@@ -0,0 +1,228 @@
+#include "../netlist.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using obwody::Designator;
+using obwody::ElementNo;
+using obwody::ElementType;
+using obwody::NetIndex;
+using obwody::NetlistAnalyzer;
+using obwody::Node;
+
+namespace {
+    string readFile(const string &path) {
+        ifstream file {path};
+        return {istreambuf_iterator<char> {file}, istreambuf_iterator<char> {}};
+    }
+
+    ostringstream out, err, floatingOut;
+
+    void error(string_view line, int lineNumber) {
+        err << "Error in line " << lineNumber << ": " << line << '\n';
+    }
+
+    void billRow(ElementType type, const ElementNo *begin, const ElementNo *end, string_view description) {
+        for (const ElementNo *it = begin; it != end; ++it) {
+            out << (it == begin ? "" : ", ") << obwody::elementLetter(type) << *it;
+        }
+        out << ": " << description << '\n';
+    }
+
+    void unconnected(const vector<Node> &nodes) {
+        err << "Warning, unconnected node(s): ";
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            err << (i == 0 ? "" : ", ") << nodes[i];
+        }
+        err << '\n';
+    }
+
+    void floating(const Node *begin, const Node *end) {
+        for (const Node *node = begin; node != end; ++node) {
+            floatingOut << (node == begin ? "" : ", ") << *node;
+        }
+        floatingOut << '\n';
+    }
+
+    // Warning at the end of @errors, empty if there is none
+    string warning(const string &errors) {
+        size_t begin = errors.rfind("Warning, unconnected node(s): ");
+        return begin == string::npos ? "" : errors.substr(begin);
+    }
+
+    bool check(const string &test) {
+        bool result = out.str() == readFile(test + ".out") && err.str() == readFile(test + ".err");
+        out.str("");
+        err.str("");
+        return result;
+    }
+}
+
+// Analyzes every netlist given as an argument several times with a single analyzer,
+// as a buffer, as a stream, line by line and in the binary form, comparing results with expected ones.
+int main(int argc, char *argv[]) {
+    NetlistAnalyzer analyzer {error, billRow, unconnected};
+
+    for (int round = 0; round < 2; ++round) {
+        analyzer.setJobs(round == 0 ? 1 : 4);
+
+        for (int i = 1; i < argc; ++i) {
+            string test {argv[i]};
+            string netlist {readFile(test + ".in")};
+
+            analyzer.analyze(netlist);
+            assert(check(test));
+
+            istringstream stream {netlist};
+            analyzer.analyze(stream);
+            assert(check(test));
+
+            analyzer.reset();
+            istringstream lines {netlist};
+            for (string line; getline(lines, line);) {
+                analyzer.addLine(line);
+            }
+            analyzer.report();
+            assert(check(test));
+
+            analyzer.analyzeCompiled(analyzer.compile(netlist));
+            assert(check(test));
+        }
+    }
+
+    // Reports of a netlist growing in the incremental mode, groups not connected to ground included,
+    // are the same as those of its whole text so far
+    NetlistAnalyzer growing {error, billRow, unconnected};
+    growing.setIncremental(true);
+    growing.setFloatingCallback(floating);
+    analyzer.setFloatingCallback(floating);
+    for (int i = 1; i < argc; ++i) {
+        string test {argv[i]};
+        istringstream lines {readFile(test + ".in")};
+        growing.reset();
+
+        string prefix;
+        size_t count = 0;
+        for (string line; getline(lines, line);) {
+            growing.addLine(line);
+            prefix += line + '\n';
+            if (++count % 97 != 0 && lines.peek() != EOF) continue;
+
+            growing.report();
+            string grownOut {out.str()}, grownWarning {warning(err.str())}, grownFloating {floatingOut.str()};
+            out.str("");
+            err.str("");
+            floatingOut.str("");
+            analyzer.analyze(prefix);
+            assert(out.str() == grownOut && warning(err.str()) == grownWarning && floatingOut.str() == grownFloating);
+            out.str("");
+            err.str("");
+            floatingOut.str("");
+        }
+    }
+    analyzer.setFloatingCallback({});
+
+    // Both directions of a net index agree with each other
+    analyzer.setIndexing(true);
+    for (int i = 1; i < argc; ++i) {
+        analyzer.analyze(readFile(string {argv[i]} + ".in"));
+        out.str("");
+        err.str("");
+
+        NetIndex index {analyzer.index()};
+        size_t nodeTerminals = 0, elementTerminals = 0;
+        set<Designator> seen;
+        index.nodes(0, 999999999, [&](Node node, const vector<Designator> &elements) {
+            assert(!elements.empty() && is_sorted(elements.begin(), elements.end()));
+            for (const Designator &element : elements) {
+                vector<Node> nodes {index.elementNodes(element)};
+                assert(count(nodes.begin(), nodes.end(), node) == 1);
+                if (seen.insert(element).second) {
+                    elementTerminals += nodes.size();
+                }
+            }
+            nodeTerminals += elements.size();
+        });
+        assert(nodeTerminals == elementTerminals);
+    }
+    analyzer.setIndexing(false);
+
+    // Lines split into tokens by the pre-pass, also across blocks and longer than them, are parsed
+    // the same as single lines
+    string netlist;
+    for (int i = 0; i < 3000; ++i) {
+        string padding(i % 100 == 0 ? 70000 + i : i % 7, i % 3 == 0 ? ' ' : '\t');
+        netlist += "R" + to_string(i) + padding + " 1k " + to_string(i % 50) + " 7" + (i % 11 ? "\r\n" : " 8\n");
+    }
+    netlist += "C1 10u 3 4";
+    analyzer.analyze(netlist);
+    string blocksOut {out.str()}, blocksErr {err.str()};
+    out.str("");
+    err.str("");
+    analyzer.reset();
+    istringstream lines {netlist};
+    for (string line; getline(lines, line);) {
+        analyzer.addLine(line);
+    }
+    analyzer.report();
+    assert(out.str() == blocksOut && err.str() == blocksErr && !blocksErr.empty());
+    out.str("");
+    err.str("");
+
+    // Repeated designators are found in a small netlist analyzed after a large one
+    string large;
+    for (int i = 0; i < 20000; ++i) {
+        large += "R" + to_string(i) + " 1k 0 1\n";
+    }
+    for (int round = 0; round < 2; ++round) {
+        analyzer.analyze(large);
+        out.str("");
+        err.str("");
+        analyzer.analyze("R1 X 0 1\nR1 Y 0 1\n");
+        assert(err.str().find("Error in line 2: R1 Y 0 1\n") != string::npos);
+        out.str("");
+        err.str("");
+    }
+
+    // Truncated binary netlists are rejected before anything is reported
+    string image {analyzer.compile("R1 X 1 2\nR1 X 2 3\n")};
+    for (size_t size = 0; size < image.size(); ++size) {
+        try {
+            analyzer.analyzeCompiled(string_view {image}.substr(0, size));
+            assert(false);
+        } catch (invalid_argument &) {
+            assert(out.str().empty() && err.str().empty());
+        }
+    }
+
+    // Designators of a binary netlist are known to lines added after it
+    analyzer.analyzeCompiled(analyzer.compile("R1 X 1 2\n"));
+    out.str("");
+    err.str("");
+    analyzer.addLine("R1 Y 3 4");
+    assert(err.str() == "Error in line 2: R1 Y 3 4\n");
+    err.str("");
+
+    // An image with a repeated designator is rejected, leaving the analyzer as with an empty netlist.
+    // It differs from a correct one only in the number of its second element.
+    analyzer.analyze("");
+    string emptyErr {err.str()};
+    err.str("");
+    string correct {analyzer.compile("R1 X 1 2\nR2 X 2 3\n")}, repeated {analyzer.compile("R1 X 1 2\nR3 X 2 3\n")};
+    size_t number = mismatch(correct.begin(), correct.end(), repeated.begin()).first - correct.begin();
+    repeated[number] = correct[number] - 1;
+    try {
+        analyzer.analyzeCompiled(repeated);
+        assert(false);
+    } catch (invalid_argument &) {
+        analyzer.report();
+        assert(out.str().empty() && err.str() == emptyErr);
+    }
+}
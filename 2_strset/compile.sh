@@ -11,5 +11,17 @@ g++ strset_test1.o strsetconst.o strset.o -o strset1 &&
 g++ -Wall -Wextra -O2 -std=c++17 -c strset_test2a.cc -o strset_test2a.o &&
 g++ -Wall -Wextra -O2 -std=c++17 -c strset_test2b.cc -o strset_test2b.o &&
 g++ strset_test2a.o strsetconst.o strset.o -o strset2a &&
-g++ strset_test2b.o strsetconst.o strset.o -o strset2b
-
+g++ strset_test2b.o strsetconst.o strset.o -o strset2b &&
+g++ -Wall -Wextra -O2 -std=c++17 -DNDEBUG -DSTRSET_THREAD_SAFE -c strset.cc -o strset_ts.o &&
+g++ -Wall -Wextra -O2 -std=c++17 -DNDEBUG -c strsetconst.cc -o strsetconst_ndebug.o &&
+g++ -Wall -Wextra -O2 -std=c++17 -c strset_test3.cc -o strset_test3.o &&
+g++ -pthread strset_test3.o strsetconst_ndebug.o strset_ts.o -o strset3 &&
+g++ -Wall -Wextra -O2 -std=c++17 -DNDEBUG -c strset.cc -o strset_ndebug.o &&
+g++ -Wall -Wextra -O2 -std=c++17 -c strset_test4.cc -o strset_test4.o &&
+g++ strset_test4.o strsetconst_ndebug.o strset_ndebug.o -o strset4 &&
+g++ -Wall -Wextra -O2 -std=c++17 -DNDEBUG -DSTRSET_FLAT -c strset.cc -o strset_flat.o &&
+g++ -Wall -Wextra -O2 -std=c++17 -c strset_test5.cc -o strset_test5.o &&
+g++ strset_test5.o strsetconst_ndebug.o strset_ndebug.o -o strset5 &&
+g++ strset_test5.o strsetconst_ndebug.o strset_flat.o -o strset5flat &&
+gcc -Wall -Wextra -O2 -std=c11 -c strset_test6.c -o strset_test6.o &&
+g++ strset_test6.o strsetconst.o strset.o -o strset6
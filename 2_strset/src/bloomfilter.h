@@ -0,0 +1,69 @@
+#ifndef BLOOMFILTER_H
+#define BLOOMFILTER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+// Included by strset.cc only, hence the anonymous namespace.
+namespace {
+
+    // Blocked Bloom filter of strings: each string sets 8 bits, one in every word of a single
+    // 64-byte block chosen by its hash, so that a test reads one cache line. With 16 bits
+    // per element, about 0.5% of strings not added pass the test.
+    class BloomFilter {
+    public:
+        // Filter for up to @capacity strings, which may be exceeded at the cost of more false positives.
+        explicit BloomFilter(size_t capacity)
+                : blocks(std::max<size_t>(1, capacity * bitsPerElement / blockBits + 1)), limit(capacity) {}
+
+        size_t capacity() const {
+            return limit;
+        }
+
+        void add(std::string_view value) {
+            uint64_t hash = std::hash<std::string_view>()(value);
+            Block &block = blocks[hash % blocks.size()];
+            uint64_t bits = mix(hash);
+            for (uint64_t &word : block.words) {
+                word |= uint64_t(1) << (bits & 63);
+                bits >>= 6;
+            }
+        }
+
+        // Returns false if @value has surely not been added.
+        bool mayContain(std::string_view value) const {
+            uint64_t hash = std::hash<std::string_view>()(value);
+            const Block &block = blocks[hash % blocks.size()];
+            uint64_t bits = mix(hash);
+            uint64_t missing = 0;
+            for (uint64_t word : block.words) {
+                missing |= ~word & uint64_t(1) << (bits & 63);
+                bits >>= 6;
+            }
+            return missing == 0;
+        }
+
+    private:
+        struct alignas(64) Block {
+            uint64_t words[8] = {};
+        };
+
+        static constexpr size_t blockBits = 512;
+        static constexpr size_t bitsPerElement = 16;
+
+        std::vector<Block> blocks;
+        size_t limit;
+
+        // Bits of positions within words, independent of those choosing the block.
+        static uint64_t mix(uint64_t hash) {
+            hash ^= hash >> 33;
+            hash *= 0xFF51AFD7ED558CCDULL;
+            return hash ^ hash >> 29;
+        }
+    };
+}
+
+#endif //BLOOMFILTER_H
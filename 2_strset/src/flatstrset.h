@@ -0,0 +1,567 @@
+#ifndef FLATSTRSET_H
+#define FLATSTRSET_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__SANITIZE_THREAD__)
+#define FLATSTRSET_TSAN
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define FLATSTRSET_TSAN
+#endif
+#endif
+
+// Included by strset.cc only, hence the anonymous namespace.
+namespace {
+
+    // Sorted set of strings kept in a B+-tree of nodes of at most maxKeys keys in contiguous storage:
+    // leaves hold keys of elements, inner nodes the last key of every child, all leaves being equally
+    // deep. A key holds the first 8 bytes of its string, compared as one big-endian number, so that
+    // most comparisons do not touch the string itself. Strings longer than that are stored in an arena
+    // of the set. Strings are ordered as std::string orders them.
+    // Copies share nodes (and the arena) until one of them changes: then it copies the nodes on the way
+    // from the root to the leaf it changes, so a copy takes constant time and near-identical sets little
+    // memory.
+    class FlatStrSet {
+        struct Key {
+            char head[8];
+            uint32_t size;
+            const char *bytes;
+
+            std::string_view view() const {
+                return {size <= sizeof(head) ? head : bytes, size};
+            }
+        };
+
+        struct Node;
+        using NodePtr = std::shared_ptr<Node>;
+
+        // Leaves have no children.
+        struct Node {
+            std::vector<Key> keys;
+            std::vector<NodePtr> children;
+        };
+
+        // Enough for more elements than fit in memory, as non-root nodes are at least a quarter full.
+        static constexpr int maxHeight = 16;
+
+    public:
+        using key_type = std::string_view;
+
+        // Keeps its path from the root, so that it can go up when it leaves a leaf.
+        class const_iterator {
+        public:
+            std::string_view operator*() const {
+                return nodes[height - 1]->keys[positions[height - 1]].view();
+            }
+
+            const_iterator &operator++() {
+                int level = height - 1;
+                if (++positions[level] < nodes[level]->keys.size()) return *this;
+
+                // Up to the first ancestor with a next child, then down to the first leaf under it.
+                do {
+                    if (--level < 0) {
+                        height = 0;
+                        return *this;
+                    }
+                } while (++positions[level] == nodes[level]->children.size());
+                for (++level; level < height; ++level) {
+                    nodes[level] = nodes[level - 1]->children[positions[level - 1]].get();
+                    positions[level] = 0;
+                }
+                return *this;
+            }
+
+            bool operator==(const const_iterator &other) const {
+                if (height == 0 || other.height == 0) return height == other.height;
+                return nodes[height - 1] == other.nodes[other.height - 1] &&
+                       positions[height - 1] == other.positions[other.height - 1];
+            }
+
+            bool operator!=(const const_iterator &other) const {
+                return !(*this == other);
+            }
+
+        private:
+            friend class FlatStrSet;
+
+            const_iterator() = default;
+
+            // Node and position in it at every level, none at the end.
+            const Node *nodes[maxHeight];
+            size_t positions[maxHeight];
+            int height = 0;
+        };
+
+        FlatStrSet() = default;
+
+        FlatStrSet(const FlatStrSet &other) {
+            *this = other;
+        }
+
+        FlatStrSet(FlatStrSet &&other) noexcept {
+            *this = std::move(other);
+        }
+
+        // Shares nodes and the arena of @other. Long strings of the copy go to chunks of its own.
+        FlatStrSet &operator=(const FlatStrSet &other) {
+            if (this != &other) {
+                root = other.root;
+                height = other.height;
+                count = other.count;
+                chunks = other.chunks;
+                chunkNext = nullptr;
+                chunkFree = 0;
+                arenaBytes = other.arenaBytes;
+                garbage = other.garbage;
+            }
+            return *this;
+        }
+
+        FlatStrSet &operator=(FlatStrSet &&other) noexcept {
+            if (this != &other) {
+                *this = other;
+                other.clear();
+            }
+            return *this;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+        const_iterator begin() const {
+            const_iterator result;
+            const Node *node = root.get();
+            for (int level = 0; level < height; ++level) {
+                result.nodes[level] = node;
+                result.positions[level] = 0;
+                if (level + 1 < height) node = node->children[0].get();
+            }
+            result.height = height;
+            return result;
+        }
+
+        const_iterator end() const {
+            return {};
+        }
+
+        const_iterator find(std::string_view value) const {
+            const_iterator result;
+            if (!locate(value, prefixOf(value), result)) return end();
+            return result;
+        }
+
+        std::pair<const_iterator, bool> insert(std::string_view value) {
+            const_iterator path;
+            if (locate(value, prefixOf(value), path)) return {path, false};
+            insertAt(value, path);
+            return {path, true};
+        }
+
+        size_t erase(std::string_view value) {
+            const_iterator path;
+            if (!locate(value, prefixOf(value), path)) return 0;
+            eraseAt(value, path);
+            return 1;
+        }
+
+        // Following functions look for @value starting from @cursor, where a value not greater than @value
+        // was looked for last (or begin()), going up the tree only as far as needed (finger search).
+        // They leave @cursor where @value is or belongs, to be passed to the next call only.
+        bool find(std::string_view value, const_iterator &cursor) const {
+            uint64_t prefix = prefixOf(value);
+            return locate(value, prefix, cursor, fingerLevel(value, prefix, cursor));
+        }
+
+        // Returns false if @value was already present.
+        bool insert(std::string_view value, const_iterator &cursor) {
+            uint64_t prefix = prefixOf(value);
+            if (locate(value, prefix, cursor, fingerLevel(value, prefix, cursor))) return false;
+            insertAt(value, cursor);
+            return true;
+        }
+
+        // Returns false if @value was not present.
+        bool erase(std::string_view value, const_iterator &cursor) {
+            uint64_t prefix = prefixOf(value);
+            if (!locate(value, prefix, cursor, fingerLevel(value, prefix, cursor))) return false;
+            eraseAt(value, cursor);
+            return true;
+        }
+
+        void clear() {
+            root = nullptr;
+            height = 0;
+            count = 0;
+            chunks = nullptr;
+            chunkNext = nullptr;
+            chunkFree = 0;
+            arenaBytes = 0;
+            garbage = 0;
+        }
+
+    private:
+        static constexpr size_t maxKeys = 64;
+        static constexpr size_t chunkSize = 1 << 12;
+
+        // Chunk of the arena, linked to the one allocated before it.
+        // Called once the count of @pointer has dropped to one, orders what follows after what the owners
+        // which let it go did with it. ThreadSanitizer does not model fences, so its builds copy the pointer
+        // instead: the increment of the count reads what the last release decremented, with the same effect.
+        template <typename T>
+        static void acquire(const std::shared_ptr<T> &pointer) {
+#ifdef FLATSTRSET_TSAN
+            std::shared_ptr<T> copy = pointer;
+#else
+            (void) pointer;
+            std::atomic_thread_fence(std::memory_order_acquire);
+#endif
+        }
+
+        struct Chunk {
+            std::unique_ptr<char[]> bytes;
+            std::shared_ptr<Chunk> previous;
+
+            // Releases chunks no longer used one by one, rather than recursively.
+            ~Chunk() {
+                std::shared_ptr<Chunk> next = std::move(previous);
+                while (next != nullptr && next.use_count() == 1) {
+                    acquire(next);
+                    next = std::move(next->previous);
+                }
+            }
+        };
+
+        NodePtr root;
+        int height = 0;
+        size_t count = 0;
+
+        // Arena: bytes of long strings, erased ones becoming garbage until the arena is rebuilt.
+        // New strings go to the free end of the last chunk, which copies of the set never use.
+        std::shared_ptr<Chunk> chunks;
+        char *chunkNext = nullptr;
+        size_t chunkFree = 0;
+        size_t arenaBytes = 0;
+        size_t garbage = 0;
+
+        // Inserts @value at @path, where locate() left it, and leaves @path on it.
+        void insertAt(std::string_view value, const_iterator &path) {
+            if (root == nullptr) {
+                root = std::make_shared<Node>();
+                root->keys.push_back(makeKey(value));
+                height = 1;
+                count = 1;
+                path = begin();
+                return;
+            }
+
+            Node *nodes[maxHeight];
+            size_t *positions = path.positions;
+            ownPath(positions, nodes);
+            Node &leaf = *nodes[height - 1];
+            leaf.keys.insert(leaf.keys.begin() + positions[height - 1], makeKey(value));
+            ++count;
+
+            // Split nodes which got too big, bottom-up, keeping the path on the new element.
+            for (int level = height - 1; level >= 0; --level) {
+                Node &current = *nodes[level];
+                if (current.keys.size() <= maxKeys) {
+                    if (level > 0) nodes[level - 1]->keys[positions[level - 1]] = current.keys.back();
+                    continue;
+                }
+
+                NodePtr right = split(current);
+                bool toRight = positions[level] >= current.keys.size();
+                if (toRight) {
+                    positions[level] -= current.keys.size();
+                    nodes[level] = right.get();
+                }
+
+                if (level == 0) {
+                    assert(height < maxHeight);
+                    auto newRoot = std::make_shared<Node>();
+                    newRoot->keys = {current.keys.back(), right->keys.back()};
+                    newRoot->children.push_back(std::move(root));
+                    newRoot->children.push_back(std::move(right));
+                    root = std::move(newRoot);
+                    std::move_backward(nodes, nodes + height, nodes + height + 1);
+                    std::move_backward(positions, positions + height, positions + height + 1);
+                    nodes[0] = root.get();
+                    positions[0] = toRight ? 1 : 0;
+                    ++height;
+                    break;
+                }
+
+                Node &parent = *nodes[level - 1];
+                size_t at = positions[level - 1];
+                parent.keys[at] = current.keys.back();
+                parent.keys.insert(parent.keys.begin() + at + 1, right->keys.back());
+                parent.children.insert(parent.children.begin() + at + 1, std::move(right));
+                if (toRight) positions[level - 1] = at + 1;
+            }
+
+            std::copy(nodes, nodes + height, path.nodes);
+            path.height = height;
+        }
+
+        // Erases @value at @path, where locate() found it, and leaves @path on the next element,
+        // or at the end if nodes had to be merged.
+        void eraseAt(std::string_view value, const_iterator &path) {
+            if (value.size() > sizeof(Key::head)) garbage += value.size();
+            Node *nodes[maxHeight];
+            size_t *positions = path.positions;
+            ownPath(positions, nodes);
+            Node &leaf = *nodes[height - 1];
+            leaf.keys.erase(leaf.keys.begin() + positions[height - 1]);
+            --count;
+            bool merged = false;
+
+            // Nodes which got less than a quarter full are merged with a sibling, or take some of its keys
+            // if there are too many of them for one node, bottom-up.
+            for (int level = height - 1; level > 0; --level) {
+                Node &current = *nodes[level];
+                Node &parent = *nodes[level - 1];
+                size_t at = positions[level - 1];
+                if (current.keys.size() >= maxKeys / 4) {
+                    parent.keys[at] = current.keys.back();
+                    continue;
+                }
+
+                merged = true;
+                size_t left = at + 1 < parent.children.size() ? at : at - 1;
+                Node &first = own(parent.children[left]), &second = own(parent.children[left + 1]);
+                if (first.keys.size() + second.keys.size() <= maxKeys) {
+                    moveKeys(second, 0, second.keys.size(), first, first.keys.size());
+                    parent.keys.erase(parent.keys.begin() + left + 1);
+                    parent.children.erase(parent.children.begin() + left + 1);
+                    parent.keys[left] = first.keys.back();
+                } else {
+                    size_t half = (first.keys.size() + second.keys.size()) / 2;
+                    if (first.keys.size() < half) {
+                        moveKeys(second, 0, half - first.keys.size(), first, first.keys.size());
+                    } else {
+                        moveKeys(first, half, first.keys.size(), second, 0);
+                    }
+                    parent.keys[left] = first.keys.back();
+                    parent.keys[left + 1] = second.keys.back();
+                }
+            }
+
+            if (height == 1 && root->keys.empty()) {
+                root = nullptr;
+                height = 0;
+            } else if (height > 1 && root->children.size() == 1) {
+                NodePtr child = std::move(root->children.front());
+                root = std::move(child);
+                --height;
+                merged = true;
+            }
+
+            if (garbage > arenaBytes / 2 && garbage > chunkSize) {
+                moveToNewArena();
+            }
+
+            if (merged || root == nullptr) {
+                path = end();
+            } else {
+                std::copy(nodes, nodes + height, path.nodes);
+                path.height = height;
+            }
+        }
+
+        // First 8 bytes of @value as a big-endian number, padded with zeros.
+        static uint64_t prefixOf(std::string_view value) {
+            uint64_t result = 0;
+            for (size_t i = 0; i < 8; ++i) {
+                result = result << 8 | (i < value.size() ? static_cast<unsigned char>(value[i]) : 0);
+            }
+            return result;
+        }
+
+        static uint64_t prefixOf(const Key &key) {
+            return prefixOf(std::string_view(key.head, sizeof(key.head)));
+        }
+
+        // Compares as std::string does. Equal prefixes of which one belongs to a short string
+        // (padded with zeros) mean that it is a prefix of the other one, even if that has NULs.
+        static int compare(const Key &key, std::string_view value, uint64_t valuePrefix) {
+            uint64_t keyPrefix = prefixOf(key);
+            if (keyPrefix != valuePrefix) return keyPrefix < valuePrefix ? -1 : 1;
+            if (key.size <= sizeof(key.head) || value.size() <= sizeof(key.head)) {
+                return key.size < value.size() ? -1 : key.size > value.size() ? 1 : 0;
+            }
+            int result = key.view().substr(sizeof(key.head)).compare(value.substr(sizeof(key.head)));
+            return result < 0 ? -1 : result > 0 ? 1 : 0;
+        }
+
+        static bool equal(const Key &key, std::string_view value) {
+            return key.size == value.size() && key.view() == value;
+        }
+
+        static size_t lowerBound(const std::vector<Key> &keys, std::string_view value, uint64_t prefix) {
+            auto less = [&](const Key &key, std::string_view) { return compare(key, value, prefix) < 0; };
+            return std::lower_bound(keys.begin(), keys.end(), value, less) - keys.begin();
+        }
+
+        // Sets @path to the element @value and returns true, if there is one. Otherwise sets it to where
+        // @value belongs, the end of the last leaf if it is greater than all elements. Searches from
+        // the node of @path at @level, the root by default.
+        bool locate(std::string_view value, uint64_t prefix, const_iterator &path, int level = 0) const {
+            path.height = height;
+            const Node *node = level == 0 ? root.get() : path.nodes[level];
+            for (; level < height; ++level) {
+                size_t position = lowerBound(node->keys, value, prefix);
+                path.nodes[level] = node;
+                if (level + 1 == height) {
+                    path.positions[level] = position;
+                    return position < node->keys.size() && equal(node->keys[position], value);
+                }
+                path.positions[level] = std::min(position, node->keys.size() - 1);
+                node = node->children[path.positions[level]].get();
+            }
+            return false;
+        }
+
+        // Level of the lowest node of @cursor whose subtree holds @value, if it is in the set,
+        // with all nodes above on the path from the root.
+        int fingerLevel(std::string_view value, uint64_t prefix, const const_iterator &cursor) const {
+            if (height == 0 || cursor.height != height) return 0;
+            int level = height - 1;
+            while (level > 0 && compare(cursor.nodes[level]->keys.back(), value, prefix) < 0) --level;
+            return level;
+        }
+
+        // Node @node, copied first if shared with another set. Once the count drops to one, changes
+        // come after reads of the sets that let it go, see acquire().
+        static Node &own(NodePtr &node) {
+            if (node.use_count() > 1) {
+                node = std::make_shared<Node>(*node);
+            } else {
+                acquire(node);
+            }
+            return *node;
+        }
+
+        // Stores in @nodes nodes at @positions from the root, copying those shared with another set.
+        void ownPath(const size_t *positions, Node **nodes) {
+            NodePtr *link = &root;
+            for (int level = 0; level < height; ++level) {
+                nodes[level] = &own(*link);
+                if (level + 1 < height) link = &nodes[level]->children[positions[level]];
+            }
+        }
+
+        // Moves keys (and children) from @begin to @end of @from to @at of @to.
+        static void moveKeys(Node &from, size_t begin, size_t end, Node &to, size_t at) {
+            to.keys.insert(to.keys.begin() + at, from.keys.begin() + begin, from.keys.begin() + end);
+            from.keys.erase(from.keys.begin() + begin, from.keys.begin() + end);
+            if (!from.children.empty()) {
+                to.children.insert(to.children.begin() + at, std::make_move_iterator(from.children.begin() + begin),
+                                   std::make_move_iterator(from.children.begin() + end));
+                from.children.erase(from.children.begin() + begin, from.children.begin() + end);
+            }
+        }
+
+        // Moves the upper half of @node to a new node.
+        static NodePtr split(Node &node) {
+            auto right = std::make_shared<Node>();
+            moveKeys(node, node.keys.size() / 2, node.keys.size(), *right, 0);
+            return right;
+        }
+
+        Key makeKey(std::string_view value) {
+            Key key{};
+            std::memcpy(key.head, value.data(), std::min(value.size(), sizeof(key.head)));
+            key.size = static_cast<uint32_t>(value.size());
+            key.bytes = value.size() > sizeof(key.head) ? store(value) : nullptr;
+            return key;
+        }
+
+        const char *store(std::string_view value) {
+            if (value.size() > chunkFree) {
+                chunkFree = std::max(chunkSize, value.size());
+                auto chunk = std::make_shared<Chunk>();
+                chunk->bytes.reset(new char[chunkFree]);
+                chunk->previous = std::move(chunks);
+                chunks = std::move(chunk);
+                chunkNext = chunks->bytes.get();
+            }
+
+            char *result = chunkNext;
+            std::memcpy(result, value.data(), value.size());
+            chunkNext += value.size();
+            chunkFree -= value.size();
+            arenaBytes += value.size();
+            return result;
+        }
+
+        // Copies bytes of long strings into a new arena, dropping garbage of the old one
+        // (kept alive as long as copies of the set use it). Nodes shared with copies stay shared,
+        // pointing to the old chunks, which the set then keeps as well, their strings counted in arenaBytes
+        // so that erasing them later adds to garbage of the arena they are counted in.
+        void moveToNewArena() {
+            std::shared_ptr<Chunk> old = std::move(chunks);
+            chunks = root != nullptr && shared(root, height) ? old : nullptr;
+            chunkFree = 0;
+            arenaBytes = 0;
+            garbage = 0;
+            if (root != nullptr) moveToNewArena(root, height);
+        }
+
+        // Returns true if any node of the subtree @node of @levels levels is shared with another set.
+        static bool shared(const NodePtr &node, int levels) {
+            if (node.use_count() > 1) return true;
+            if (levels == 1) return false;
+            return std::any_of(node->children.begin(), node->children.end(),
+                               [levels](const NodePtr &child) { return shared(child, levels - 1); });
+        }
+
+        // Bytes of long strings in the subtree @node of @levels levels.
+        static size_t longBytes(const Node &node, int levels) {
+            size_t result = 0;
+            if (levels == 1) {
+                for (const Key &key : node.keys) {
+                    if (key.size > sizeof(key.head)) result += key.size;
+                }
+            } else {
+                for (const NodePtr &child : node.children) result += longBytes(*child, levels - 1);
+            }
+            return result;
+        }
+
+        void moveToNewArena(NodePtr &link, int levels) {
+            if (link.use_count() > 1) {
+                arenaBytes += longBytes(*link, levels);
+                return;
+            }
+            Node &node = own(link);
+            if (levels == 1) {
+                for (Key &key : node.keys) {
+                    if (key.size > sizeof(key.head)) key.bytes = store(key.view());
+                }
+                return;
+            }
+            for (size_t child = 0; child < node.children.size(); ++child) {
+                moveToNewArena(node.children[child], levels - 1);
+                node.keys[child] = node.children[child]->keys.back();
+            }
+        }
+    };
+}
+
+#endif //FLATSTRSET_H
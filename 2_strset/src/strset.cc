@@ -1,10 +1,27 @@
-#include <unordered_map>
 #include <set>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <string_view>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <sstream>
 #include "strset.h"
 #include "strsetconst.h"
 #include <cassert>
 #include <limits>
 
+#ifdef STRSET_THREAD_SAFE
+#include <atomic>
+#endif
+
+#ifdef STRSET_FLAT
+#include "flatstrset.h"
+#endif
+#include "bloomfilter.h"
+
 namespace {
 
 #ifndef NDEBUG
@@ -13,27 +30,207 @@ namespace {
     const bool debug = false;
 #endif
 
+#ifdef STRSET_THREAD_SAFE
+    // Sets are spread over shards of the registry, each shard and each set has its own reader/writer lock.
+    using Mutex = std::shared_mutex;
+    template <typename T>
+    using Atomic = std::atomic<T>;
+    using Counter = Atomic<size_t>;
+    const size_t shardsCount = 64;
+
+    // Accesses are relaxed unless told otherwise: counters are statistics only, nothing else
+    // is synchronized through them.
+    template <typename T>
+    T load(const Atomic<T> &value, std::memory_order order = std::memory_order_relaxed) {
+        return value.load(order);
+    }
+
+    template <typename T, typename U>
+    void store(Atomic<T> &value, U newValue, std::memory_order order = std::memory_order_relaxed) {
+        value.store(newValue, order);
+    }
+
+    // Sets @value to @newValue if it is still @expected.
+    template <typename T>
+    bool replace(Atomic<T> &value, T expected, T newValue, std::memory_order order) {
+        return value.compare_exchange_strong(expected, newValue, order, std::memory_order_relaxed);
+    }
+
+    void increment(Counter &counter) { counter.fetch_add(1, std::memory_order_relaxed); }
+#else
+    // Locks doing nothing, for single-threaded builds.
+    struct Mutex {
+        void lock() {}
+        void unlock() {}
+        void lock_shared() {}
+        void unlock_shared() {}
+    };
+    template <typename T>
+    using Atomic = T;
+    using Counter = Atomic<size_t>;
+    const size_t shardsCount = 1;
+
+    template <typename T>
+    T load(const T &value, std::memory_order = std::memory_order_relaxed) { return value; }
+
+    template <typename T, typename U>
+    void store(T &value, U newValue, std::memory_order = std::memory_order_relaxed) { value = newValue; }
+
+    template <typename T>
+    bool replace(T &value, T expected, T newValue, std::memory_order) {
+        if (value != expected) return false;
+        value = newValue;
+        return true;
+    }
+
+    void increment(Counter &counter) { ++counter; }
+#endif
+
+    using ReadLock = std::shared_lock<Mutex>;
+    using WriteLock = std::unique_lock<Mutex>;
+
+#ifdef STRSET_FLAT
+    using StrSet = FlatStrSet;
+#else
     using StrSet = std::set<std::string>;
-    using Map = std::unordered_map<unsigned long, StrSet>;
+#endif
 
-    // Function that returns static map, which maps IDs of sets of strings with afromentioned sets.
-    Map &map() {
-        static auto *res = new Map();
+    // Set together with the lock guarding it and its optional Bloom filter, with numbers of elements
+    // removed since the filter was built, of tests for elements not in the set and of those among
+    // them which the filter let through. Counters are updated under the lock for reading.
+    // Fingerprint is the sum of hashes of elements, so it does not depend on the order of insertions.
+    // Version grows with every change of the set.
+    struct Entry {
+        Mutex mutex;
+        StrSet set;
+        uint64_t fingerprint = 0;
+        unsigned long version = 0;
+        std::unique_ptr<BloomFilter> filter;
+        size_t filterRemoved = 0;
+        Counter filterMisses{0};
+        Counter filterFalsePositives{0};
+    };
+
+    // Pointer to a set keeps it alive even if the set gets deleted by another thread meanwhile.
+    using EntryPtr = std::shared_ptr<Entry>;
+
+    // Slot of the registry: its generation and its set, nullptr if the slot is free. Generation is
+    // increased whenever the set is deleted, so that IDs of deleted sets do not refer to later ones.
+    using Slot = std::pair<unsigned long, EntryPtr>;
+
+    // Slot map: sets of a shard in a dense vector, with free slots reused by new sets, oldest first,
+    // but only once there are minFreeSlots of them. Until then IDs simply grow, as they always did.
+    struct Shard {
+        Mutex mutex;
+        std::vector<Slot> slots;
+        std::deque<size_t> freeSlots;
+    };
+
+    const size_t minFreeSlots = 64;
+
+    using Registry = std::array<Shard, shardsCount>;
+
+    // ID of a set consists of generation of its slot (upper half of bits) and index of the slot
+    // (lower half), slots of all shards being numbered alternately.
+    const int indexBits = std::numeric_limits<unsigned long>::digits / 2;
+    const unsigned long indexMask = (1UL << indexBits) - 1;
+    const unsigned long maxGeneration = std::numeric_limits<unsigned long>::max() >> indexBits;
+
+    // Function that returns static registry, which maps IDs of sets of strings with afromentioned sets.
+    Registry &registry() {
+        static auto *res = new Registry();
         return *res;
     }
 
+    Shard &shardOf(unsigned long id) {
+        return registry()[(id & indexMask) % shardsCount];
+    }
+
+    size_t slotOf(unsigned long id) {
+        return (id & indexMask) / shardsCount;
+    }
+
+    // Returns slot of the set having ID @id, or nullptr if there is none. Requires lock of the shard.
+    Slot *findSlot(Shard &shard, unsigned long id) {
+        size_t slot = slotOf(id);
+        if (slot >= shard.slots.size()) return nullptr;
+
+        Slot &result = shard.slots[slot];
+        return result.first == id >> indexBits && result.second != nullptr ? &result : nullptr;
+    }
+
+    // Returns set having ID @id, or nullptr if there is none.
+    EntryPtr find(unsigned long id) {
+        Shard &shard = shardOf(id);
+        ReadLock lock(shard.mutex);
+        Slot *slot = findSlot(shard, id);
+        return slot == nullptr ? nullptr : slot->second;
+    }
+
+    // Puts set @entry (a new empty one by default) into a free slot of one of the shards, in turns,
+    // and returns its ID.
+    unsigned long create(EntryPtr entry = std::make_shared<Entry>()) {
+        static Counter nextShard{0};
+        size_t shardIndex = nextShard++ % shardsCount;
+        Shard &shard = registry()[shardIndex];
+
+        WriteLock lock(shard.mutex);
+        size_t slot;
+        if (shard.freeSlots.size() < minFreeSlots) {
+            slot = shard.slots.size();
+            shard.slots.emplace_back(0, nullptr);
+        } else {
+            slot = shard.freeSlots.front();
+            shard.freeSlots.pop_front();
+        }
+        shard.slots[slot].second = std::move(entry);
+
+        size_t index = slot * shardsCount + shardIndex;
+        // In case of running out of IDs:
+        assert(index <= indexMask);
+        return shard.slots[slot].first << indexBits | index;
+    }
+
+    // Deletes set having ID @id, returns false if there is none.
+    bool erase(unsigned long id) {
+        Shard &shard = shardOf(id);
+        WriteLock lock(shard.mutex);
+        Slot *slot = findSlot(shard, id);
+        if (slot == nullptr) return false;
+
+        slot->second = nullptr;
+        // A slot which ran out of generations is never used again.
+        if (slot->first != maxGeneration) {
+            ++slot->first;
+            shard.freeSlots.push_back(slotOf(id));
+        }
+        return true;
+    }
+
+    // Writes whole line at once, so that lines of different threads do not interleave.
+    template<typename... Args>
+    inline void printLine(const Args &... args) {
+        std::ostringstream line;
+        (line << ... << args) << '\n';
+        std::cerr << line.str();
+    }
+
     // Following functions are used to print debug information in case -NDEBUG is not set.
     inline void printDebug(const char *s1) {
-        if (debug) std::cerr << s1 << '\n';
+        if (debug) printLine(s1);
     }
 
     inline void printDebug(const char *s1, unsigned long id, const char *s2) {
-        if (debug) std::cerr << s1 << id << s2 << '\n';
+        if (debug) printLine(s1, id, s2);
     }
 
     inline void
     printDebug(const char *s1, unsigned long id, const char *s2, size_t n, const char *s3) {
-        if (debug) std::cerr << s1 << id << s2 << n << s3 << '\n';
+        if (debug) printLine(s1, id, s2, n, s3);
+    }
+
+    inline void printDebug(const char *s1, unsigned long id, const char *s2, double x) {
+        if (debug) printLine(s1, id, s2, x);
     }
 
     inline void printDebug(const char *s1, unsigned long id, const char *s2, const char *value,
@@ -41,8 +238,256 @@ namespace {
         if (debug) {
             // Conditional operator to process @value of NULL properly.
             std::string val = value == nullptr ? "NULL" : "\"" + std::string(value) + "\"";
-            std::cerr << s1 << id << s2 << val << s3 << '\n';
+            printLine(s1, id, s2, val, s3);
+        }
+    }
+
+    // Locks sets @e1 and @e2 (any of which may be missing) for reading,
+    // always in the same order, so that no two threads wait for each other.
+    std::pair<ReadLock, ReadLock> lockBoth(const EntryPtr &e1, const EntryPtr &e2) {
+        Entry *first = e1.get(), *second = e2.get();
+        if (std::less<Entry *>()(second, first)) std::swap(first, second);
+
+        ReadLock lock1, lock2;
+        if (first != nullptr) lock1 = ReadLock(first->mutex);
+        if (second != nullptr && second != first) lock2 = ReadLock(second->mutex);
+        return {std::move(lock1), std::move(lock2)};
+    }
+
+    // Element of a set, as passed to its methods.
+    using Value = StrSet::key_type;
+
+    // Filters hold at least that many elements, twice as many as the set when built.
+    const size_t minFilterCapacity = 1024;
+
+    // Builds filter of set @entry anew. Requires the lock for writing.
+    void rebuildFilter(Entry &entry) {
+        entry.filter = std::make_unique<BloomFilter>(std::max(minFilterCapacity, 2 * entry.set.size()));
+        for (std::string_view value : entry.set) {
+            entry.filter->add(value);
+        }
+        entry.filterRemoved = 0;
+    }
+
+    // Hash of an element spread over all bits, so that fingerprints of different sets rarely agree.
+    uint64_t elementHash(std::string_view value) {
+        uint64_t hash = std::hash<std::string_view>()(value);
+        hash ^= hash >> 33;
+        hash *= 0xFF51AFD7ED558CCDULL;
+        hash ^= hash >> 33;
+        hash *= 0xC4CEB9FE1A85EC53ULL;
+        return hash ^ hash >> 33;
+    }
+
+    // Position in a set where the previous value of a sorted batch was looked for, where the search
+    // for the next one starts.
+    using Cursor = StrSet::const_iterator;
+
+#ifdef STRSET_FLAT
+    // FlatStrSet goes up the tree from the cursor only as far as needed.
+    bool findAt(const StrSet &set, std::string_view value, Cursor &cursor) {
+        return set.find(value, cursor);
+    }
+
+    bool insertAt(StrSet &set, std::string_view value, Cursor &cursor) {
+        return set.insert(value, cursor);
+    }
+
+    bool eraseAt(StrSet &set, std::string_view value, Cursor &cursor) {
+        return set.erase(value, cursor);
+    }
+#else
+    // Moves @cursor to the first element not less than @value, a few steps forward, or searching
+    // from the root if @value is farther. Returns true if it is @value.
+    bool seek(const StrSet &set, const Value &value, Cursor &cursor) {
+        for (int steps = 0; cursor != set.end() && *cursor < value; ++cursor) {
+            if (++steps > 8) {
+                cursor = set.lower_bound(value);
+                break;
+            }
+        }
+        return cursor != set.end() && *cursor == value;
+    }
+
+    bool findAt(const StrSet &set, std::string_view value, Cursor &cursor) {
+        return seek(set, Value(value), cursor);
+    }
+
+    bool insertAt(StrSet &set, std::string_view value, Cursor &cursor) {
+        Value element(value);
+        if (seek(set, element, cursor)) return false;
+        cursor = set.emplace_hint(cursor, std::move(element));
+        return true;
+    }
+
+    bool eraseAt(StrSet &set, std::string_view value, Cursor &cursor) {
+        if (!seek(set, Value(value), cursor)) return false;
+        cursor = set.erase(cursor);
+        return true;
+    }
+#endif
+
+    // Following functions operate on set @entry, keeping its filter, fingerprint and version up to date. Those modifying it
+    // require the lock for writing, others for reading. Values of a batch are looked for from @cursor.
+
+    // Returns false if @value was already present.
+    bool insertInto(Entry &entry, std::string_view value, Cursor *cursor = nullptr) {
+        if (cursor != nullptr ? !insertAt(entry.set, value, *cursor) : !entry.set.insert(Value(value)).second) {
+            return false;
+        }
+        entry.fingerprint += elementHash(value);
+        ++entry.version;
+
+        if (entry.filter != nullptr) {
+            if (entry.set.size() > entry.filter->capacity()) {
+                rebuildFilter(entry);
+            } else {
+                entry.filter->add(value);
+            }
+        }
+        return true;
+    }
+
+    // Returns false if @value was not present. Filter keeps removed elements until it is rebuilt,
+    // which happens once there are more of them than a quarter of elements of the set.
+    bool removeFrom(Entry &entry, std::string_view value, Cursor *cursor = nullptr) {
+        if (cursor != nullptr ? !eraseAt(entry.set, value, *cursor) : entry.set.erase(Value(value)) == 0) {
+            return false;
+        }
+        entry.fingerprint -= elementHash(value);
+        ++entry.version;
+
+        if (entry.filter != nullptr && ++entry.filterRemoved > entry.set.size() / 4) {
+            rebuildFilter(entry);
         }
+        return true;
+    }
+
+    void clearEntry(Entry &entry) {
+        entry.set.clear();
+        entry.fingerprint = 0;
+        ++entry.version;
+        if (entry.filter != nullptr) rebuildFilter(entry);
+    }
+
+    bool contains(Entry &entry, std::string_view value, Cursor *cursor = nullptr) {
+        bool passed = entry.filter == nullptr || entry.filter->mayContain(value);
+        bool found = passed && (cursor != nullptr ? findAt(entry.set, value, *cursor)
+                                                  : entry.set.find(Value(value)) != entry.set.end());
+        if (entry.filter != nullptr && !found) {
+            increment(entry.filterMisses);
+            if (passed) increment(entry.filterFalsePositives);
+        }
+        return found;
+    }
+
+    // Results of recent comparisons, each for a pair of IDs (the smaller one first) and versions
+    // of both sets at the time. A pair has a single place, taken by whichever pair came last.
+    // Places are read without locking (a seqlock): the sequence number of a place is odd while it
+    // is being written, and what was read is ignored if the number has changed meanwhile. A place
+    // already being written by another thread is left to it.
+    struct alignas(64) Comparison {
+        Atomic<unsigned long> sequence{0};
+        Atomic<unsigned long> id1{0}, id2{0};
+        Atomic<unsigned long> version1{0}, version2{0};
+        Atomic<int> result{0};
+    };
+
+    using ComparisonCache = std::array<Comparison, 1024>;
+
+    ComparisonCache &comparisonCache() {
+        static auto *res = new ComparisonCache();
+        return *res;
+    }
+
+    Comparison &cachedComparison(unsigned long id1, unsigned long id2) {
+        ComparisonCache &cache = comparisonCache();
+        return cache[(id1 * 0x9E3779B97F4A7C15ULL ^ id2) % cache.size()];
+    }
+
+    // Fields are written and read with release and acquire, so a reader that sees any of them
+    // written also sees the odd sequence number written before.
+    bool loadComparison(unsigned long id1, unsigned long id2, unsigned long version1, unsigned long version2,
+                        int &result) {
+        const Comparison &cached = cachedComparison(id1, id2);
+        unsigned long sequence = load(cached.sequence, std::memory_order_acquire);
+        if (sequence % 2 == 1) return false;
+        bool found = load(cached.id1, std::memory_order_acquire) == id1 &&
+                     load(cached.id2, std::memory_order_acquire) == id2 &&
+                     load(cached.version1, std::memory_order_acquire) == version1 &&
+                     load(cached.version2, std::memory_order_acquire) == version2;
+        result = load(cached.result, std::memory_order_acquire);
+        return found && load(cached.sequence) == sequence;
+    }
+
+    void storeComparison(unsigned long id1, unsigned long id2, unsigned long version1, unsigned long version2,
+                         int result) {
+        Comparison &cached = cachedComparison(id1, id2);
+        unsigned long sequence = load(cached.sequence);
+        if (sequence % 2 == 1 || !replace(cached.sequence, sequence, sequence + 1, std::memory_order_acquire)) {
+            return;
+        }
+        store(cached.id1, id1, std::memory_order_release);
+        store(cached.id2, id2, std::memory_order_release);
+        store(cached.version1, version1, std::memory_order_release);
+        store(cached.version2, version2, std::memory_order_release);
+        store(cached.result, result, std::memory_order_release);
+        store(cached.sequence, sequence + 2, std::memory_order_release);
+    }
+
+    // Compares sets @entry1 and @entry2 having IDs @id1 and @id2 element by element, unless neither
+    // has changed since they were last compared. Requires locks of both sets for reading.
+    int compareEntries(unsigned long id1, const Entry &entry1, unsigned long id2, const Entry &entry2) {
+        if (&entry1 == &entry2) return 0;
+
+        bool swapped = id2 < id1;
+        const Entry &first = swapped ? entry2 : entry1, &second = swapped ? entry1 : entry2;
+        int result;
+        if (loadComparison(std::min(id1, id2), std::max(id1, id2), first.version, second.version, result)) {
+            return swapped ? -result : result;
+        }
+
+        auto s1 = first.set.begin(), s2 = second.set.begin(), end1 = first.set.end(), end2 = second.set.end();
+        result = 0;
+        for (; s1 != end1 && s2 != end2 && result == 0; ++s1, ++s2) {
+            int cmp = (*s1).compare(*s2);
+            result = cmp < 0 ? -1 : cmp > 0 ? 1 : 0;
+        }
+        if (result == 0 && (s1 != end1 || s2 != end2)) {
+            result = s1 == end1 ? -1 : 1;
+        }
+
+        storeComparison(std::min(id1, id2), std::max(id1, id2), first.version, second.version, result);
+        return swapped ? -result : result;
+    }
+
+    // Returns indices of non-NULL values of a batch, sorted by value (equal values keeping their order),
+    // so that the set is walked in order. Stores values in @views, of lengths @lengths if these are given.
+    std::vector<size_t> sortBatch(const char *const *values, const size_t *lengths, size_t count,
+                                  std::vector<std::string_view> &views) {
+        views.assign(count, std::string_view());
+        std::vector<size_t> order;
+        for (size_t i = 0; i < count; ++i) {
+            if (values[i] == nullptr) continue;
+            views[i] = lengths == nullptr ? std::string_view(values[i]) : std::string_view(values[i], lengths[i]);
+            order.push_back(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return views[a] < views[b]; });
+        return order;
+    }
+
+    // Prepares a batch of @count @values: zeroes @results (if given) and reports invalid values.
+    // Returns false if there are no values at all.
+    bool startBatch(const char *name, const char *const *values, size_t count, int *results) {
+        if (results != nullptr) std::fill(results, results + count, 0);
+        if (values == nullptr) {
+            if (count > 0) printDebug(name, count, " invalid value(s) (NULL)");
+            return false;
+        }
+
+        size_t invalid = std::count(values, values + count, nullptr);
+        if (invalid > 0) printDebug(name, invalid, " invalid value(s) (NULL)");
+        return true;
     }
 }
 
@@ -51,17 +496,9 @@ namespace jnp1 {
     unsigned long strset_new() {
         printDebug("strset_new()");
 
-        // During the execution @nextId stores value of ID assigned to next set created by strset_new().
-        static unsigned long nextId = 0;
-
-        // In case of @nextId overflow:
-        assert(nextId != std::numeric_limits<unsigned long>::max());
-
-        StrSet set;
-        map().insert(make_pair(nextId, set));
-
-        printDebug("strset_new: set ", nextId, " created");
-        return nextId++;
+        unsigned long id = create();
+        printDebug("strset_new: set ", id, " created");
+        return id;
     }
 
     void strset_delete(unsigned long id) {
@@ -72,12 +509,10 @@ namespace jnp1 {
             return;
         }
 
-        auto it = map().find(id);
-        if (it == map().end()) {
-            printDebug("strset_delete: set ", id, " does not exist");
-        } else {
-            map().erase(it);
+        if (erase(id)) {
             printDebug("strset_delete: set ", id, " deleted");
+        } else {
+            printDebug("strset_delete: set ", id, " does not exist");
         }
     }
 
@@ -89,12 +524,14 @@ namespace jnp1 {
             return 1;
         }
 
-        auto it = map().find(id);
-        if (it == map().end()) {
+        EntryPtr entry = find(id);
+        if (entry == nullptr) {
             printDebug("strset_size: set ", id, " does not exist");
             return 0;
         } else {
-            size_t result = it->second.size();
+            ReadLock lock(entry->mutex);
+            size_t result = entry->set.size();
+            lock.unlock();
             printDebug("strset_size: set ", id, " contains ", result, " element(s)");
             return result;
         }
@@ -108,22 +545,24 @@ namespace jnp1 {
             return;
         }
 
-        auto it = map().find(id);
-        // Whitelisting first insertion of "42" into the 42 Set.
-        if (id == strset42() && !(it->second.empty())) {
-            printDebug("strset_insert: attempt to insert into the 42 Set");
+        EntryPtr entry = find(id);
+        bool is42 = id == strset42();
+        if (entry == nullptr) {
+            printDebug("strset_insert: set ", id, " does not exist");
             return;
         }
 
-        if (it == map().end()) {
-            printDebug("strset_insert: set ", id, " does not exist");
+        WriteLock lock(entry->mutex);
+        // Whitelisting first insertion of "42" into the 42 Set.
+        if (is42 && !(entry->set.empty())) {
+            lock.unlock();
+            printDebug("strset_insert: attempt to insert into the 42 Set");
+        } else if (insertInto(*entry, value)) {
+            lock.unlock();
+            printDebug("strset_insert: set ", id, ", element ", value, " inserted");
         } else {
-            if (it->second.find(value) == it->second.end()) {
-                it->second.insert(value);
-                printDebug("strset_insert: set ", id, ", element ", value, " inserted");
-            } else {
-                printDebug("strset_insert: set ", id, ", element ", value, " was already present");
-            }
+            lock.unlock();
+            printDebug("strset_insert: set ", id, ", element ", value, " was already present");
         }
     }
 
@@ -132,6 +571,7 @@ namespace jnp1 {
 
         if (value == nullptr) {
             printDebug("strset_remove: invalid value (NULL)");
+            return;
         }
 
         if (id == strset42()) {
@@ -139,16 +579,19 @@ namespace jnp1 {
             return;
         }
 
-        auto it = map().find(id);
-        if (it == map().end()) {
+        EntryPtr entry = find(id);
+        if (entry == nullptr) {
             printDebug("strset_remove: set ", id, " does not exist");
+            return;
+        }
+
+        WriteLock lock(entry->mutex);
+        if (!removeFrom(*entry, value)) {
+            lock.unlock();
+            printDebug("strset_remove: set ", id, " does not contain the element ", value);
         } else {
-            if (it->second.find(value) == it->second.end()) {
-                printDebug("strset_remove: set ", id, " does not contain the element ", value);
-            } else {
-                it->second.erase(value);
-                printDebug("strset_remove: set ", id, ", element ", value, " removed");
-            }
+            lock.unlock();
+            printDebug("strset_remove: set ", id, ", element ", value, " removed");
         }
     }
 
@@ -170,18 +613,21 @@ namespace jnp1 {
             }
         }
 
-        auto it = map().find(id);
-        if (it == map().end()) {
+        EntryPtr entry = find(id);
+        if (entry == nullptr) {
             printDebug("strset_test: set ", id, " does not exist");
             return 0;
+        }
+
+        ReadLock lock(entry->mutex);
+        bool found = contains(*entry, value);
+        lock.unlock();
+        if (!found) {
+            printDebug("strset_test: set ", id, " does not contain the element ", value);
+            return 0;
         } else {
-            if (it->second.find(value) == it->second.end()) {
-                printDebug("strset_test: set ", id, " does not contain the element ", value);
-                return 0;
-            } else {
-                printDebug("strset_test: set ", id, " contains the element ", value);
-                return 1;
-            }
+            printDebug("strset_test: set ", id, " contains the element ", value);
+            return 1;
         }
     }
 
@@ -193,11 +639,13 @@ namespace jnp1 {
             return;
         }
 
-        auto it = map().find(id);
-        if (it == map().end()) {
+        EntryPtr entry = find(id);
+        if (entry == nullptr) {
             printDebug("strset_clear: set ", id, " does not exist");
         } else {
-            it->second.clear();
+            WriteLock lock(entry->mutex);
+            clearEntry(*entry);
+            lock.unlock();
             printDebug("strset_clear: set ", id, " cleared");
         }
     }
@@ -205,55 +653,253 @@ namespace jnp1 {
     int strset_comp(unsigned long id1, unsigned long id2) {
         printDebug("strset_comp(", id1, ", ", id2, ")");
 
-        auto it1 = map().find(id1), it2 = map().find(id2), end = map().end();
-        if (it1 == end) {
-            if (it2 == end) {
+        EntryPtr entry1 = find(id1), entry2 = find(id2);
+        auto locks = lockBoth(entry1, entry2);
+        if (entry1 == nullptr) {
+            if (entry2 == nullptr) {
+                locks = {};
                 printDebug("strset_comp: result of comparing set ", id1, " to set ", id2, " is 0");
                 printDebug("strset_comp: set ", id1, " does not exist");
                 printDebug("strset_comp: set ", id2, " does not exist");
                 return 0;
-            } else if (it2->second.empty()) {
+            } else if (entry2->set.empty()) {
+                locks = {};
                 printDebug("strset_comp: result of comparing set ", id1, " to set ", id2, " is 0");
                 printDebug("strset_comp: set ", id1, " does not exist");
                 return 0;
             } else {
+                locks = {};
                 printDebug("strset_comp: result of comparing set ", id1, " to set ", id2, " is -1");
                 printDebug("strset_comp: set ", id1, " does not exist");
                 return -1;
             }
-        } else if (it2 == end) {
-            if (it1->second.empty()) {
+        } else if (entry2 == nullptr) {
+            if (entry1->set.empty()) {
+                locks = {};
                 printDebug("strset_comp: result of comparing set ", id1, " to set ", id2, " is 0");
                 printDebug("strset_comp: set ", id2, " does not exist");
                 return 0;
             } else {
+                locks = {};
                 printDebug("strset_comp: result of comparing set ", id1, " to set ", id2, " is 1");
                 printDebug("strset_comp: set ", id2, " does not exist");
                 return 1;
             }
         }
 
-        auto s1 = it1->second.begin(), s2 = it2->second.begin(),
-                end1 = it1->second.end(), end2 = it2->second.end();
-        for (; s1 != end1 && s2 != end2; ++s1, ++s2) {
-            int cmp = (*s1).compare(*s2);
-            if (cmp < 0) {
-                printDebug("strset_comp: result of comparing set ", id1, " to set ", id2, " is -1");
-                return -1;
-            } else if (cmp > 0) {
-                printDebug("strset_comp: result of comparing set ", id1, " to set ", id2, " is 1");
-                return 1;
+        int result = compareEntries(id1, *entry1, id2, *entry2);
+        locks = {};
+
+        printDebug("strset_comp: result of comparing set ", id1, " to set ", id2,
+                   result < 0 ? " is -1" : result > 0 ? " is 1" : " is 0");
+        return result;
+    }
+
+    unsigned long strset_clone(unsigned long id) {
+        printDebug("strset_clone(", id, ")");
+
+        auto copy = std::make_shared<Entry>();
+        EntryPtr entry = find(id);
+        if (entry != nullptr) {
+            ReadLock lock(entry->mutex);
+            copy->set = entry->set;
+            copy->fingerprint = entry->fingerprint;
+        }
+
+        unsigned long cloneId = create(std::move(copy));
+        if (entry == nullptr) {
+            printDebug("strset_clone: set ", id, " does not exist");
+            printDebug("strset_clone: set ", cloneId, " created");
+        } else {
+            printDebug("strset_clone: set ", cloneId, " created as a copy of set ", id, "");
+        }
+        return cloneId;
+    }
+
+    int strset_equal(unsigned long id1, unsigned long id2) {
+        printDebug("strset_equal(", id1, ", ", id2, ")");
+
+        EntryPtr entry1 = find(id1), entry2 = find(id2);
+        auto locks = lockBoth(entry1, entry2);
+        bool equal;
+        if (entry1 == nullptr || entry2 == nullptr) {
+            // A set which does not exist equals only empty sets.
+            equal = (entry1 == nullptr || entry1->set.empty()) && (entry2 == nullptr || entry2->set.empty());
+        } else {
+            equal = entry1->set.size() == entry2->set.size() && entry1->fingerprint == entry2->fingerprint &&
+                    compareEntries(id1, *entry1, id2, *entry2) == 0;
+        }
+        locks = {};
+
+        if (entry1 == nullptr) printDebug("strset_equal: set ", id1, " does not exist");
+        if (entry2 == nullptr) printDebug("strset_equal: set ", id2, " does not exist");
+        printDebug("strset_equal: sets ", id1, " and ", id2, equal ? " are equal" : " differ");
+        return equal;
+    }
+
+    size_t strset_insert_many(unsigned long id, const char *const *values, const size_t *lengths,
+                              size_t count, int *results) {
+        printDebug("strset_insert_many(", id, ", ", count, " value(s))");
+
+        if (!startBatch("strset_insert_many: ", values, count, results)) return 0;
+
+        EntryPtr entry = find(id);
+        bool is42 = id == strset42();
+        if (entry == nullptr) {
+            printDebug("strset_insert_many: set ", id, " does not exist");
+            return 0;
+        }
+
+        std::vector<std::string_view> views;
+        std::vector<size_t> order = sortBatch(values, lengths, count, views);
+        size_t inserted = 0;
+        bool rejected42 = false;
+        {
+            WriteLock lock(entry->mutex);
+            Cursor cursor = entry->set.begin();
+            for (size_t i : order) {
+                // Whitelisting first insertion of "42" into the 42 Set.
+                if (is42 && !(entry->set.empty())) {
+                    rejected42 = true;
+                    break;
+                }
+                if (insertInto(*entry, views[i], &cursor)) {
+                    ++inserted;
+                    if (results != nullptr) results[i] = 1;
+                }
             }
         }
-        if (s1 == end1 && s2 == end2) {
-            printDebug("strset_comp: result of comparing set ", id1, " to set ", id2, " is 0");
+
+        if (rejected42) {
+            printDebug("strset_insert_many: attempt to insert into the 42 Set");
+            return inserted;
+        }
+        printDebug("strset_insert_many: set ", id, ", ", inserted, " element(s) inserted");
+        return inserted;
+    }
+
+    size_t strset_remove_many(unsigned long id, const char *const *values, const size_t *lengths,
+                              size_t count, int *results) {
+        printDebug("strset_remove_many(", id, ", ", count, " value(s))");
+
+        if (!startBatch("strset_remove_many: ", values, count, results)) return 0;
+
+        if (id == strset42()) {
+            printDebug("strset_remove_many: attempt to remove from the 42 Set");
             return 0;
-        } else if (s1 == end1) {
-            printDebug("strset_comp: result of comparing set ", id1, " to set ", id2, " is -1");
-            return -1;
+        }
+
+        EntryPtr entry = find(id);
+        if (entry == nullptr) {
+            printDebug("strset_remove_many: set ", id, " does not exist");
+            return 0;
+        }
+
+        std::vector<std::string_view> views;
+        std::vector<size_t> order = sortBatch(values, lengths, count, views);
+        size_t removed = 0;
+        {
+            WriteLock lock(entry->mutex);
+            Cursor cursor = entry->set.begin();
+            for (size_t i : order) {
+                if (removeFrom(*entry, views[i], &cursor)) {
+                    ++removed;
+                    if (results != nullptr) results[i] = 1;
+                }
+            }
+        }
+
+        printDebug("strset_remove_many: set ", id, ", ", removed, " element(s) removed");
+        return removed;
+    }
+
+    size_t strset_test_many(unsigned long id, const char *const *values, const size_t *lengths,
+                            size_t count, int *results) {
+        printDebug("strset_test_many(", id, ", ", count, " value(s))");
+
+        if (!startBatch("strset_test_many: ", values, count, results)) return 0;
+
+        std::vector<std::string_view> views;
+        std::vector<size_t> order = sortBatch(values, lengths, count, views);
+        size_t found = 0;
+        if (id == strset42()) {
+            for (size_t i : order) {
+                if (views[i] == "42") {
+                    ++found;
+                    if (results != nullptr) results[i] = 1;
+                }
+            }
+            printDebug("strset_test_many: the 42 Set contains ", found, " of the elements");
+            return found;
+        }
+
+        EntryPtr entry = find(id);
+        if (entry == nullptr) {
+            printDebug("strset_test_many: set ", id, " does not exist");
+            return 0;
+        }
+
+        {
+            ReadLock lock(entry->mutex);
+            Cursor cursor = entry->set.begin();
+            for (size_t i : order) {
+                if (contains(*entry, views[i], &cursor)) {
+                    ++found;
+                    if (results != nullptr) results[i] = 1;
+                }
+            }
+        }
+
+        printDebug("strset_test_many: set ", id, " contains ", found, " of the elements");
+        return found;
+    }
+
+    void strset_filter_enable(unsigned long id) {
+        printDebug("strset_filter_enable(", id, ")");
+
+        if (id == strset42()) {
+            printDebug("strset_filter_enable: the 42 Set needs no filter");
+            return;
+        }
+
+        EntryPtr entry = find(id);
+        if (entry == nullptr) {
+            printDebug("strset_filter_enable: set ", id, " does not exist");
+            return;
+        }
+
+        WriteLock lock(entry->mutex);
+        if (entry->filter != nullptr) {
+            lock.unlock();
+            printDebug("strset_filter_enable: set ", id, " already has a filter");
         } else {
-            printDebug("strset_comp: result of comparing set ", id1, " to set ", id2, " is 1");
-            return 1;
+            rebuildFilter(*entry);
+            store(entry->filterMisses, 0);
+            store(entry->filterFalsePositives, 0);
+            lock.unlock();
+            printDebug("strset_filter_enable: set ", id, " has a filter now");
         }
     }
+
+    double strset_filter_fp_rate(unsigned long id) {
+        printDebug("strset_filter_fp_rate(", id, ")");
+
+        EntryPtr entry = id == strset42() ? nullptr : find(id);
+        bool filtered = false;
+        size_t misses = 0, falsePositives = 0;
+        if (entry != nullptr) {
+            ReadLock lock(entry->mutex);
+            filtered = entry->filter != nullptr;
+            misses = load(entry->filterMisses);
+            falsePositives = load(entry->filterFalsePositives);
+        }
+        if (!filtered) {
+            printDebug("strset_filter_fp_rate: set ", id, " has no filter");
+            return 0;
+        }
+
+        double result = misses == 0 ? 0 : double(falsePositives) / double(misses);
+        printDebug("strset_filter_fp_rate: set ", id, " false positive rate is ", result);
+        return result;
+    }
 }
@@ -40,6 +40,39 @@ namespace jnp1 {
     // Compares sets having IDs @id1 and @id2.
     int strset_comp(unsigned long id1, unsigned long id2);
 
+    // Creates a new set having the same elements as the set having ID @id, empty if there is no such set,
+    // and returns its ID. The copy does not keep a filter. Built with STRSET_FLAT, it takes constant time,
+    // the sets sharing their storage until one of them changes.
+    unsigned long strset_clone(unsigned long id);
+
+    // Returns 1 if sets having IDs @id1 and @id2 have the same elements, a set that does not exist
+    // being empty, 0 otherwise. Sets of different sizes or fingerprints are told apart at once.
+    int strset_equal(unsigned long id1, unsigned long id2);
+
+    // Following functions act as their counterparts called for each of @count @values in turn,
+    // but find the set once and go through the values in sorted order. Values are NUL-terminated,
+    // unless their lengths are given in @lengths. If @results is not NULL, 1 is written at the
+    // position of every value inserted, removed or found respectively, 0 at others.
+    // Return the number of such values.
+
+    size_t strset_insert_many(unsigned long id, const char *const *values, const size_t *lengths,
+                              size_t count, int *results);
+
+    size_t strset_remove_many(unsigned long id, const char *const *values, const size_t *lengths,
+                              size_t count, int *results);
+
+    size_t strset_test_many(unsigned long id, const char *const *values, const size_t *lengths,
+                            size_t count, int *results);
+
+    // If there exists a set having ID @id, makes it keep a Bloom filter of its elements, which answers
+    // most tests for elements not in the set without searching it. Otherwise does nothing.
+    void strset_filter_enable(unsigned long id);
+
+    // If there exists a set having ID @id and it has a filter, returns the fraction of tests
+    // for elements not in the set since the filter was enabled which the filter did not answer.
+    // Otherwise returns 0.
+    double strset_filter_fp_rate(unsigned long id);
+
 #ifdef __cplusplus
     }
 }
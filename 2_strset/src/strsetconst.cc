@@ -1,6 +1,9 @@
 #include "strsetconst.h"
 #include "strset.h"
 
+#include <atomic>
+#include <mutex>
+
 namespace {
 
 #ifndef NDEBUG
@@ -16,16 +19,24 @@ namespace {
     }
 
     // Function that creates the unmodifiable 42 Set if it has not been created yet
-    // and returns its ID.
+    // and returns its ID. Other threads wait for the set to be created, while strset_insert
+    // called here gets the ID already (hence the recursive mutex).
     unsigned long &init() {
         static unsigned long result;
-        static bool initiated = false;
-        if (!initiated) {
-            initiated = true;
-            printDebug("strsetconst init invoked");
-            result = ::jnp1::strset_new();
-            ::jnp1::strset_insert(result, "42");
-            printDebug("strsetconst init finished");
+        static std::atomic<bool> ready{false};
+        if (!ready.load(std::memory_order_acquire)) {
+            static std::recursive_mutex mutex;
+            std::lock_guard<std::recursive_mutex> lock(mutex);
+
+            static bool initiated = false;
+            if (!initiated) {
+                initiated = true;
+                printDebug("strsetconst init invoked");
+                result = ::jnp1::strset_new();
+                ::jnp1::strset_insert(result, "42");
+                printDebug("strsetconst init finished");
+                ready.store(true, std::memory_order_release);
+            }
         }
         return result;
     }
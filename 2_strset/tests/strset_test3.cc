@@ -0,0 +1,70 @@
+#include "strset.h"
+#include "strsetconst.h"
+
+#include <cassert>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Needs strset.cc built with -DSTRSET_THREAD_SAFE.
+
+namespace {
+    const int threadsCount = 8;
+    const int wordsCount = 1000;
+
+    std::string word(int i) {
+        return "word" + std::to_string(i);
+    }
+
+    void worker(int number, unsigned long shared) {
+        // The 42 Set is created by whichever thread comes first
+        unsigned long id42 = ::jnp1::strset42();
+        assert(::jnp1::strset_test(id42, "42"));
+
+        unsigned long own = ::jnp1::strset_new();
+        assert(own != id42 && own != shared);
+        for (int round = 0; round < 20; ++round) {
+            for (int i = 0; i < wordsCount; ++i) {
+                assert(::jnp1::strset_test(shared, word(i).c_str()));
+                assert(!::jnp1::strset_test(shared, word(-i - 1).c_str()));
+            }
+            std::string mine = word(number) + "/" + std::to_string(round);
+            ::jnp1::strset_insert(own, mine.c_str());
+            ::jnp1::strset_insert(shared, mine.c_str());
+            assert(::jnp1::strset_test(own, mine.c_str()));
+            ::jnp1::strset_remove(shared, mine.c_str());
+            assert(::jnp1::strset_comp(own, own) == 0);
+            // Elements of the shared set other than "word0" to "word999" come and go, but every
+            // own set is greater: it has no "word0", the smallest element of the shared one
+            assert(::jnp1::strset_comp(own, shared) == 1 && ::jnp1::strset_comp(shared, own) == -1);
+
+            // A clone changes on its own while others change the shared set, both copying what they change
+            unsigned long clone = ::jnp1::strset_clone(shared);
+            ::jnp1::strset_remove(clone, word(round * threadsCount + number).c_str());
+            assert(!::jnp1::strset_test(clone, word(round * threadsCount + number).c_str()));
+            ::jnp1::strset_delete(clone);
+        }
+        assert(::jnp1::strset_size(own) == 20);
+        assert(::jnp1::strset_comp(own, id42) == 1);
+        ::jnp1::strset_delete(own);
+        assert(::jnp1::strset_size(own) == 0);
+    }
+}
+
+int main() {
+    unsigned long shared = ::jnp1::strset_new();
+    for (int i = 0; i < wordsCount; ++i) {
+        ::jnp1::strset_insert(shared, word(i).c_str());
+    }
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadsCount; ++i) {
+        threads.emplace_back(worker, i, shared);
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    assert(::jnp1::strset_size(shared) == wordsCount);
+    ::jnp1::strset_delete(shared);
+}
@@ -0,0 +1,48 @@
+#include "strset.h"
+#include "strsetconst.h"
+
+#include <cassert>
+#include <vector>
+
+// IDs of deleted sets are recycled with a new generation (upper half of bits of the ID).
+
+int main() {
+    unsigned long s1 = ::jnp1::strset_new();
+    ::jnp1::strset_insert(s1, "foo");
+    ::jnp1::strset_delete(s1);
+
+    unsigned long s2 = ::jnp1::strset_new();
+    assert(s2 != s1);
+    assert(::jnp1::strset_size(s2) == 0);
+
+    // The stale ID does not refer to the new set
+    ::jnp1::strset_insert(s1, "bar");
+    assert(::jnp1::strset_size(s1) == 0);
+    assert(!::jnp1::strset_test(s2, "bar"));
+    ::jnp1::strset_delete(s1);
+    ::jnp1::strset_insert(s2, "baz");
+    assert(::jnp1::strset_test(s2, "baz"));
+
+    // The 42 Set is unaffected by recycling
+    unsigned long id42 = ::jnp1::strset42();
+    assert(::jnp1::strset_test(id42, "42"));
+
+    // Many sets created and deleted use a few slots only
+    std::vector<unsigned long> ids;
+    for (int round = 0; round < 100000; ++round) {
+        for (int i = 0; i < 10; ++i) {
+            ids.push_back(::jnp1::strset_new());
+            ::jnp1::strset_insert(ids.back(), "x");
+        }
+        for (unsigned long id : ids) {
+            assert((id & 0xFFFFFFFFUL) < 128);
+            ::jnp1::strset_delete(id);
+            assert(::jnp1::strset_size(id) == 0);
+        }
+        ids.clear();
+    }
+
+    assert(::jnp1::strset_test(s2, "baz"));
+    assert(::jnp1::strset_test(id42, "42"));
+    ::jnp1::strset_delete(s2);
+}
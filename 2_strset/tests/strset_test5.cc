@@ -0,0 +1,266 @@
+#include "strset.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// Random operations checked against std::set, for any backend (e.g. built with -DSTRSET_FLAT).
+// Strings share long prefixes and are around 8 bytes long, some bytes are above 127.
+// Run as "strset5 bench [max]", measures time of building sets of 1M, 2M, ... up to max (8M) elements.
+
+namespace {
+    const int setsCount = 4;
+
+    std::string randomString(std::mt19937 &random) {
+        static const std::string alphabet = "ab\x7f\x80\xff";
+        static const std::vector<std::string> prefixes = {"", "prefix", "prefix__", "prefix__long"};
+        std::string result = prefixes[random() % prefixes.size()];
+        for (size_t length = random() % 6; length > 0; --length) {
+            result += alphabet[random() % alphabet.size()];
+        }
+        return result;
+    }
+
+    int compare(const std::set<std::string> &set1, const std::set<std::string> &set2) {
+        return set1 < set2 ? -1 : set2 < set1 ? 1 : 0;
+    }
+
+    // Inserting elements in random order should take about the same time per element for any size,
+    // a clone changed in one element time growing with the height of the tree (with FlatStrSet)
+    void bench(size_t max) {
+        std::mt19937 random(42);
+        printf("%12s %10s %14s %18s\n", "elements", "seconds", "ns/element", "clone+insert us");
+        for (size_t count = 1000000; count <= max; count *= 2) {
+            std::vector<std::string> values;
+            for (size_t i = 0; i < count; ++i) {
+                values.push_back("element " + std::to_string(i));
+            }
+            std::shuffle(values.begin(), values.end(), random);
+
+            unsigned long id = ::jnp1::strset_new();
+            auto start = std::chrono::steady_clock::now();
+            for (const std::string &value : values) {
+                ::jnp1::strset_insert(id, value.c_str());
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            const int clones = 10;
+            start = std::chrono::steady_clock::now();
+            for (int i = 0; i < clones; ++i) {
+                unsigned long clone = ::jnp1::strset_clone(id);
+                ::jnp1::strset_insert(clone, "element");
+                ::jnp1::strset_delete(clone);
+            }
+            double cloneSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printf("%12zu %10.2f %14.0f %18.1f\n", count, seconds, seconds * 1e9 / count, cloneSeconds * 1e6 / clones);
+            ::jnp1::strset_delete(id);
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && std::strcmp(argv[1], "bench") == 0) {
+        bench(argc > 2 ? std::stoul(argv[2]) : 8000000);
+        return 0;
+    }
+
+    std::mt19937 random(42);
+    std::vector<unsigned long> ids;
+    std::vector<std::set<std::string>> expected(setsCount);
+    for (int i = 0; i < setsCount; ++i) {
+        ids.push_back(::jnp1::strset_new());
+    }
+    // Sets with filters answer the same
+    ::jnp1::strset_filter_enable(ids[0]);
+    ::jnp1::strset_filter_enable(ids[1]);
+
+    for (int step = 0; step < 300000; ++step) {
+        int i = random() % setsCount;
+        std::string value = randomString(random);
+        switch (random() % 8) {
+            case 0:
+            case 1:
+            case 2:
+                ::jnp1::strset_insert(ids[i], value.c_str());
+                expected[i].insert(value);
+                break;
+            case 3:
+            case 4:
+                ::jnp1::strset_remove(ids[i], value.c_str());
+                expected[i].erase(value);
+                break;
+            case 5:
+                assert(::jnp1::strset_test(ids[i], value.c_str()) == (int) expected[i].count(value));
+                break;
+            case 6: {
+                int j = random() % setsCount;
+                // Repeated comparisons of unchanged sets come from the cache
+                assert(::jnp1::strset_comp(ids[i], ids[j]) == compare(expected[i], expected[j]));
+                assert(::jnp1::strset_comp(ids[j], ids[i]) == compare(expected[j], expected[i]));
+                assert(::jnp1::strset_equal(ids[i], ids[j]) == (expected[i] == expected[j]));
+                break;
+            }
+            default:
+                if (random() % 1000 == 0) {
+                    ::jnp1::strset_clear(ids[i]);
+                    expected[i].clear();
+                } else if (random() % 500 == 0) {
+                    // Set and its clone change independently from now on
+                    int j = random() % setsCount;
+                    unsigned long clone = ::jnp1::strset_clone(ids[j]);
+                    assert(::jnp1::strset_comp(clone, ids[j]) == 0);
+                    ::jnp1::strset_delete(ids[i]);
+                    ids[i] = clone;
+                    expected[i] = expected[j];
+                    if (i < 2) ::jnp1::strset_filter_enable(ids[i]);
+                }
+                break;
+        }
+        assert(::jnp1::strset_size(ids[i]) == expected[i].size());
+    }
+
+    assert(::jnp1::strset_filter_fp_rate(ids[2]) == 0);
+
+    // Batches, whose values are looked for in sorted order, agree with std::set
+    unsigned long batched = ::jnp1::strset_new();
+    std::set<std::string> batchedExpected;
+    for (int round = 0; round < 2000; ++round) {
+        std::vector<std::string> batch(1 + random() % 300);
+        std::vector<const char *> values;
+        for (std::string &value : batch) {
+            value = randomString(random);
+            values.push_back(value.c_str());
+        }
+        std::vector<int> results(batch.size());
+        switch (round % 4) {
+            case 0:
+            case 1:
+                ::jnp1::strset_insert_many(batched, values.data(), nullptr, batch.size(), results.data());
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    assert(results[i] == batchedExpected.insert(batch[i]).second);
+                }
+                break;
+            case 2:
+                ::jnp1::strset_remove_many(batched, values.data(), nullptr, batch.size(), results.data());
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    assert(results[i] == (int) batchedExpected.erase(batch[i]));
+                }
+                break;
+            default:
+                ::jnp1::strset_test_many(batched, values.data(), nullptr, batch.size(), results.data());
+                for (size_t i = 0; i < batch.size(); ++i) {
+                    assert(results[i] == (int) batchedExpected.count(batch[i]));
+                }
+                break;
+        }
+        assert(::jnp1::strset_size(batched) == batchedExpected.size());
+    }
+    ids.push_back(batched);
+
+    // Enough elements for a few levels of a tree, inserted and removed in random order
+    std::vector<std::string> many;
+    for (int i = 0; i < 200000; ++i) {
+        many.push_back((i % 3 ? "many " : "many long elements ") + std::to_string(i));
+    }
+    std::shuffle(many.begin(), many.end(), random);
+    unsigned long shuffled = ::jnp1::strset_new(), ordered = ::jnp1::strset_new();
+    for (const std::string &value : many) {
+        ::jnp1::strset_insert(shuffled, value.c_str());
+    }
+    std::sort(many.begin(), many.end());
+    for (size_t i = 0; i < many.size(); i += 2) {
+        ::jnp1::strset_insert(ordered, many[i].c_str());
+    }
+    std::shuffle(many.begin(), many.end(), random);
+    for (const std::string &value : many) {
+        if (::jnp1::strset_test(ordered, value.c_str())) continue;
+        ::jnp1::strset_remove(shuffled, value.c_str());
+        assert(!::jnp1::strset_test(shuffled, value.c_str()));
+    }
+    assert(::jnp1::strset_size(shuffled) == many.size() / 2 && ::jnp1::strset_comp(shuffled, ordered) == 0);
+    for (const std::string &value : many) {
+        ::jnp1::strset_remove(shuffled, value.c_str());
+    }
+    assert(::jnp1::strset_size(shuffled) == 0 && ::jnp1::strset_comp(shuffled, 123456789) == 0);
+    ids.push_back(shuffled);
+    ids.push_back(ordered);
+
+    // Clones of clones, each missing another element, with long strings in a shared arena
+    std::vector<unsigned long> clones = {::jnp1::strset_new()};
+    for (int i = 0; i < 1000; ++i) {
+        ::jnp1::strset_insert(clones[0], ("long string number " + std::to_string(i)).c_str());
+    }
+    for (int i = 0; i < 100; ++i) {
+        clones.push_back(::jnp1::strset_clone(clones.back()));
+        ::jnp1::strset_remove(clones.back(), ("long string number " + std::to_string(i)).c_str());
+    }
+    ::jnp1::strset_clear(clones[0]);
+    for (int i = 1; i <= 100; ++i) {
+        assert(::jnp1::strset_size(clones[i]) == 1000u - i);
+        assert(!::jnp1::strset_test(clones[i], ("long string number " + std::to_string(i - 1)).c_str()));
+        assert(::jnp1::strset_test(clones[i], ("long string number " + std::to_string(i)).c_str()));
+    }
+    assert(::jnp1::strset_size(::jnp1::strset_clone(123456789)) == 0);
+
+    // Strings of a clone survive removal of most of them from the original, which rebuilds its arena
+    unsigned long original = ::jnp1::strset_new();
+    for (int i = 0; i < 20000; ++i) {
+        ::jnp1::strset_insert(original, ("long string number " + std::to_string(i)).c_str());
+    }
+    unsigned long copy = ::jnp1::strset_clone(original);
+    for (int i = 0; i < 19000; ++i) {
+        ::jnp1::strset_remove(original, ("long string number " + std::to_string(i)).c_str());
+    }
+    ::jnp1::strset_insert(copy, "long string number -1");
+    for (int i = -1; i < 20000; ++i) {
+        std::string value = "long string number " + std::to_string(i);
+        assert(::jnp1::strset_test(copy, value.c_str()));
+        assert(::jnp1::strset_test(original, value.c_str()) == (i >= 19000));
+    }
+    ::jnp1::strset_delete(copy);
+    for (int i = 19000; i < 20000; ++i) {
+        ::jnp1::strset_remove(original, ("long string number " + std::to_string(i)).c_str());
+    }
+    assert(::jnp1::strset_size(original) == 0);
+    ids.push_back(original);
+    ids.insert(ids.end(), clones.begin(), clones.end());
+
+    // Sets built in different orders have the same fingerprint
+    unsigned long forward = ::jnp1::strset_new(), backward = ::jnp1::strset_new();
+    for (int i = 0; i < 100; ++i) {
+        ::jnp1::strset_insert(forward, std::to_string(i).c_str());
+        ::jnp1::strset_insert(backward, std::to_string(99 - i).c_str());
+    }
+    assert(::jnp1::strset_equal(forward, backward));
+    ::jnp1::strset_remove(backward, "50");
+    assert(!::jnp1::strset_equal(forward, backward) && ::jnp1::strset_comp(forward, backward) == -1);
+    ::jnp1::strset_insert(backward, "50");
+    assert(::jnp1::strset_equal(forward, backward) && ::jnp1::strset_comp(forward, backward) == 0);
+    ::jnp1::strset_clear(forward);
+    assert(!::jnp1::strset_equal(forward, backward) && ::jnp1::strset_equal(forward, 123456789));
+    ids.push_back(forward);
+    ids.push_back(backward);
+
+    // Without removals (which stay in the filter for a while), almost all tests
+    // for elements not in the set are answered by the filter
+    unsigned long filtered = ::jnp1::strset_new();
+    ::jnp1::strset_filter_enable(filtered);
+    for (int i = 0; i < 10000; ++i) {
+        ::jnp1::strset_insert(filtered, ("in" + std::to_string(i)).c_str());
+    }
+    for (int i = 0; i < 10000; ++i) {
+        assert(!::jnp1::strset_test(filtered, ("out" + std::to_string(i)).c_str()));
+    }
+    assert(::jnp1::strset_filter_fp_rate(filtered) < 0.02);
+    ids.push_back(filtered);
+
+    for (unsigned long id : ids) {
+        ::jnp1::strset_delete(id);
+    }
+}
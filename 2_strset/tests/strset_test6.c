@@ -0,0 +1,46 @@
+#include "strset.h"
+#include "strsetconst.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+int main() {
+    unsigned long s1, s2;
+    const char *values[] = {"foo", "bar", NULL, "foo", "baz"};
+    const char *probes[] = {"baz", "qux", "foo", NULL};
+    const char *withNul[] = {"a\0b", "a\0c", "a"};
+    const size_t lengths[] = {3, 3, 1};
+    int results[5];
+
+    s1 = strset_new();
+    assert(strset_insert_many(s1, values, NULL, 5, results) == 3);
+    assert(results[0] == 1 && results[1] == 1 && results[2] == 0 && results[3] == 0 && results[4] == 1);
+    assert(strset_size(s1) == 3);
+
+    assert(strset_test_many(s1, probes, NULL, 4, results) == 2);
+    assert(results[0] == 1 && results[1] == 0 && results[2] == 1 && results[3] == 0);
+
+    assert(strset_remove_many(s1, probes, NULL, 4, NULL) == 2);
+    assert(strset_size(s1) == 1);
+    assert(strset_test(s1, "bar"));
+
+    /* The same as single calls, also for sets that do not exist and the 42 Set */
+    assert(strset_insert_many(s1 + 1000, values, NULL, 5, results) == 0);
+    assert(results[0] == 0);
+    assert(strset_insert_many(strset42(), values, NULL, 5, NULL) == 0);
+    assert(strset_remove_many(strset42(), probes, NULL, 4, NULL) == 0);
+    assert(strset_size(strset42()) == 1);
+    assert(strset_test_many(strset42(), probes, NULL, 4, results) == 0);
+    assert(strset_insert_many(s1, NULL, NULL, 2, results) == 0);
+
+    /* Values with explicit lengths may contain NULs */
+    s2 = strset_new();
+    assert(strset_insert_many(s2, withNul, lengths, 3, NULL) == 3);
+    assert(strset_size(s2) == 3);
+    assert(strset_test(s2, "a"));
+    assert(strset_comp(s1, s2) == 1);
+
+    strset_delete(s1);
+    strset_delete(s2);
+    return 0;
+}